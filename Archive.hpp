@@ -0,0 +1,325 @@
+/** 
+ * @file Archive.hpp
+ * @brief This file contains streams that start with a header describing
+ * the format of the data.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * An @a ArchiveSink writes a header at the beginning of the data and then
+ * forwards everything to another sink. The header contains a magic number,
+ * the version of the format, the byte order and the width of the sizes of
+ * containers and strings, which is 64 bits by default.
+ * 
+ * An @a ArchiveSource reads the header back and exposes the format to
+ * @a read_from_file . If the data does not start with a header, it was written
+ * before headers were introduced and @a LEGACY_FILE_FORMAT is assumed, so old
+ * files can still be read.
+ * 
+ * The header takes FILE_HEADER_SIZE bytes:
+ * - 8 bytes: magic number.
+ * - 2 bytes: version.
+ * - 1 byte: 1 if little-endian, 2 if big-endian.
+ * - 1 byte: width of sizes (4 or 8).
+ * - 1 byte: flags. Bit 0 is set in portable archives (version 4 or later).
+ * - 3 bytes: reserved, zero.
+ * Multi-byte fields of the header use the byte order of the archive.
+ * 
+ * Archives can be written in either byte order and read on any machine: numbers
+ * stored in the opposite byte order are converted while reading or writing them,
+ * whole arrays at a time (see ByteOrder.hpp). Portable archives also store numbers
+ * with fixed widths (see @a FileFormat and @a PORTABLE_FILE_FORMAT ), so that
+ * they can be exchanged between machines where long, wchar_t or long double
+ * have different sizes:
+ * 
+ * ArchiveSink archive(file, PORTABLE_FILE_FORMAT);
+ * 
+ * Only numbers, and complex numbers, arrays and enumerations made of them, are
+ * converted. Other trivially copyable types are still saved as a raw copy of
+ * their bytes, so they should implement write_to_file and read_from_file to be portable.
+ * 
+ * An @a ArchiveSink can also choose the encoding of the vectors and deques of
+ * integers written to it (see Encodings.hpp) with @a set_integer_encoding .
+ */
+
+#ifndef ALS_UTILITIES_ARCHIVE_HPP
+#define ALS_UTILITIES_ARCHIVE_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include "ByteOrder.hpp"
+#include "Encodings.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Size in bytes of the header of an archive.
+     */
+    inline constexpr size_t FILE_HEADER_SIZE = 16;
+
+    /**
+     * @brief Magic number at the beginning of every archive.
+     */
+    inline constexpr unsigned char FILE_HEADER_MAGIC[8] = {0x89, 'A', 'L', 'S', '\r', '\n', 0x1a, '\n'};
+
+    /**
+     * @brief Fills the header of an archive with the given format.
+     * 
+     * @param format
+     * @param header buffer of FILE_HEADER_SIZE bytes.
+     */
+    void inline encode_file_header(const FileFormat& format, std::byte* header)
+    {
+        if (format.size_width != 4 && format.size_width != 8)
+        {
+            throw std::invalid_argument("encode_file_header: sizes must be 4 or 8 bytes wide.");
+        }
+        if (format.version == 0 || format.version > FILE_FORMAT_VERSION)
+        {
+            throw std::invalid_argument("encode_file_header: unsupported version.");
+        }
+        if (format.portable && format.version < 4)
+        {
+            throw std::invalid_argument("encode_file_header: portable archives require version 4.");
+        }
+        const bool swapped = (format.little_endian != (std::endian::native == std::endian::little));
+        const unsigned short version = swapped ? byte_swap(format.version) : format.version;
+        std::memcpy(header, FILE_HEADER_MAGIC, 8);
+        std::memcpy(header + 8, &version, 2);
+        header[10] = std::byte(format.little_endian ? 1 : 2);
+        header[11] = std::byte(format.size_width);
+        header[12] = std::byte(format.portable ? 1 : 0);
+        std::memset(header + 13, 0, 3);
+    }
+
+    /**
+     * @brief Decodes the header of an archive. Throws std::runtime_error if the
+     * header is not valid.
+     * 
+     * @param header buffer of FILE_HEADER_SIZE bytes that starts with FILE_HEADER_MAGIC.
+     * @return FileFormat
+     */
+    FileFormat inline decode_file_header(const std::byte* header)
+    {
+        FileFormat format;
+        const unsigned char order = static_cast<unsigned char>(header[10]);
+        if (order != 1 && order != 2)
+        {
+            throw std::runtime_error("decode_file_header: invalid byte order.");
+        }
+        format.little_endian = (order == 1);
+        std::memcpy(&format.version, header + 8, 2);
+        if (format.little_endian != (std::endian::native == std::endian::little))
+        {
+            format.version = byte_swap(format.version);
+        }
+        if (format.version == 0 || format.version > FILE_FORMAT_VERSION)
+        {
+            throw std::runtime_error("decode_file_header: unsupported version.");
+        }
+        format.size_width = static_cast<unsigned char>(header[11]);
+        if (format.size_width != 4 && format.size_width != 8)
+        {
+            throw std::runtime_error("decode_file_header: invalid width of sizes.");
+        }
+        const unsigned char flags = static_cast<unsigned char>(header[12]);
+        if ((flags & ~1) != 0 || (flags != 0 && format.version < 4))
+        {
+            throw std::runtime_error("decode_file_header: invalid flags.");
+        }
+        format.portable = (flags & 1);
+        return format;
+    }
+
+    /**
+     * @brief Checks whether a buffer starts with the magic number of an archive.
+     * 
+     * @param data
+     * @param size size of the buffer in bytes.
+     * @return true
+     * @return false
+     */
+    bool inline has_file_header(const std::byte* data, const size_t size)
+    {
+        return size >= FILE_HEADER_SIZE && std::memcmp(data, FILE_HEADER_MAGIC, 8) == 0;
+    }
+
+    /**
+     * @brief Sink that writes the header of an archive and then forwards
+     * everything to another sink.
+     * 
+     * @tparam Sink a FILE pointer or a sink.
+     */
+    template <class Sink>
+    class ArchiveSink
+    {
+    public:
+        /**
+         * @brief Construct a new Archive Sink object and write the header.
+         * 
+         * @param sink
+         * @param format
+         */
+        explicit ArchiveSink(stream_reference_t<Sink> sink, const FileFormat& format = FileFormat())
+            : sink_(sink), format_(format), integer_encoding_(Encoding::RAW)
+        {
+            std::byte header[FILE_HEADER_SIZE];
+            encode_file_header(format_, header);
+            write_bytes(sink_, header, FILE_HEADER_SIZE);
+        }
+
+        void write(const void* data, const size_t bytes) { write_bytes(sink_, data, bytes); }
+        void flush() { flush_stream(sink_); }
+        size_t tell() const { return stream_position(sink_); }
+
+        void patch(const size_t offset, const void* data, const size_t bytes)
+        {
+            patch_bytes(sink_, offset, data, bytes);
+        }
+
+        const FileFormat& format() const { return format_; }
+
+        /**
+         * @brief Sets the encoding of the vectors and deques of integers written
+         * from now on. Requires an archive of version 2 or later.
+         * 
+         * @param encoding 
+         */
+        void set_integer_encoding(const Encoding encoding)
+        {
+            if (format_.version < 2 || !is_valid_encoding<int>(encoding))
+            {
+                throw std::invalid_argument("ArchiveSink: invalid encoding for integers.");
+            }
+            integer_encoding_ = encoding;
+        }
+
+        Encoding integer_encoding() const { return integer_encoding_; }
+
+    private:
+        stream_reference_t<Sink> sink_;
+        FileFormat format_;
+        Encoding integer_encoding_;
+    };
+
+    template <class Sink>
+    ArchiveSink(Sink&) -> ArchiveSink<Sink>;
+
+    template <class Sink>
+    ArchiveSink(Sink&, const FileFormat&) -> ArchiveSink<Sink>;
+
+    ArchiveSink(FILE*) -> ArchiveSink<FILE*>;
+
+    ArchiveSink(FILE*, const FileFormat&) -> ArchiveSink<FILE*>;
+
+    /**
+     * @brief Source that reads the header of an archive, if there is one,
+     * and then forwards everything to another source.
+     * 
+     * @tparam Source a FILE pointer or a source.
+     */
+    template <class Source>
+    class ArchiveSource
+    {
+    public:
+        /**
+         * @brief Construct a new Archive Source object and read the header. If there
+         * is no header, the bytes that were inspected are given back by @a read .
+         * 
+         * @param source
+         */
+        explicit ArchiveSource(stream_reference_t<Source> source)
+            : source_(source), format_(LEGACY_FILE_FORMAT), pending_begin_(0), pending_end_(0)
+        {
+            // We compare the magic number byte by byte, so that short legacy files
+            // are not read beyond their end.
+            while (pending_end_ < 8 && read_byte(pending_[pending_end_]))
+            {
+                const bool matches = static_cast<unsigned char>(pending_[pending_end_]) == FILE_HEADER_MAGIC[pending_end_];
+                pending_end_++;
+                if (!matches)
+                {
+                    return;
+                }
+            }
+            if (pending_end_ < 8)
+            {
+                return;
+            }
+            read_bytes(source_, pending_ + 8, FILE_HEADER_SIZE - 8);
+            format_ = decode_file_header(pending_);
+            pending_end_ = 0;
+        }
+
+        void read(void* data, size_t bytes)
+        {
+            const size_t pending = std::min(bytes, pending_end_ - pending_begin_);
+            std::memcpy(data, pending_ + pending_begin_, pending);
+            pending_begin_ += pending;
+            read_bytes(source_, static_cast<std::byte*>(data) + pending, bytes - pending);
+        }
+
+        void skip(size_t bytes)
+        {
+            const size_t pending = std::min(bytes, pending_end_ - pending_begin_);
+            pending_begin_ += pending;
+            skip_bytes(source_, bytes - pending);
+        }
+
+        size_t tell() const { return stream_position(source_) - (pending_end_ - pending_begin_); }
+
+        const FileFormat& format() const { return format_; }
+
+    private:
+        bool read_byte(std::byte& byte)
+        {
+            if constexpr (std::is_pointer_v<Source>)
+            {
+                if (fread(&byte, 1, 1, source_) == 1)
+                {
+                    return true;
+                }
+                if (ferror(source_))
+                {
+                    throw std::system_error(errno, std::generic_category(), "ArchiveSource: read failed");
+                }
+                return false;
+            }
+            else
+            {
+                try
+                {
+                    read_bytes(source_, &byte, 1);
+                    return true;
+                }
+                catch (const EndOfData&)
+                {
+                    return false;
+                }
+            }
+        }
+
+        stream_reference_t<Source> source_;
+        FileFormat format_;
+        std::byte pending_[FILE_HEADER_SIZE];
+        size_t pending_begin_;
+        size_t pending_end_;
+    };
+
+    template <class Source>
+    ArchiveSource(Source&) -> ArchiveSource<Source>;
+
+    ArchiveSource(FILE*) -> ArchiveSource<FILE*>;
+}
+
+#endif // ALS_UTILITIES_ARCHIVE_HPP
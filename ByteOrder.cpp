@@ -0,0 +1,154 @@
+#ifndef ALS_UTILITIES_BYTE_ORDER_CPP
+#define ALS_UTILITIES_BYTE_ORDER_CPP
+
+#include "ByteOrder.hpp"
+
+#include <cstring>
+
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ALS_UTILITIES_BYTE_ORDER_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define ALS_UTILITIES_BYTE_ORDER_NEON
+#endif
+
+using namespace als::utilities;
+
+namespace
+{
+    // Swaps the elements that the vectorised versions leave at the end.
+    template <class U>
+    void swap_tail(const unsigned char* in, unsigned char* out, size_t count)
+    {
+        for (; count > 0; count--)
+        {
+            U value;
+            std::memcpy(&value, in, sizeof(U));
+            value = byte_swap(value);
+            std::memcpy(out, &value, sizeof(U));
+            in += sizeof(U);
+            out += sizeof(U);
+        }
+    }
+
+    void swap_portable(const unsigned char* in, unsigned char* out, const size_t count, const size_t width)
+    {
+        switch (width)
+        {
+            case 2: swap_tail<std::uint16_t>(in, out, count); break;
+            case 4: swap_tail<std::uint32_t>(in, out, count); break;
+            case 8: swap_tail<std::uint64_t>(in, out, count); break;
+        }
+    }
+
+#ifdef ALS_UTILITIES_BYTE_ORDER_X86
+    // Shuffle that reverses each element of a 16-byte block.
+    __attribute__((target("ssse3")))
+    __m128i shuffle_mask(const size_t width)
+    {
+        alignas(16) unsigned char mask[16];
+        for (size_t i = 0; i < 16; i++)
+        {
+            mask[i] = static_cast<unsigned char>(i - i % width + (width - 1 - i % width));
+        }
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+    }
+
+    __attribute__((target("ssse3")))
+    void swap_ssse3(const unsigned char* in, unsigned char* out, const size_t count, const size_t width)
+    {
+        const __m128i mask = shuffle_mask(width);
+        const size_t bytes = count * width;
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(block, mask));
+        }
+        swap_portable(in + i, out + i, (bytes - i) / width, width);
+    }
+
+    __attribute__((target("avx2")))
+    void swap_avx2(const unsigned char* in, unsigned char* out, const size_t count, const size_t width)
+    {
+        // vpshufb shuffles each 128-bit lane on its own, so the mask is repeated.
+        const __m128i half = shuffle_mask(width);
+        const __m256i mask = _mm256_broadcastsi128_si256(half);
+        const size_t bytes = count * width;
+        size_t i = 0;
+        for (; i + 64 <= bytes; i += 64)
+        {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 32));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(a, mask));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32), _mm256_shuffle_epi8(b, mask));
+        }
+        for (; i + 16 <= bytes; i += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(block, half));
+        }
+        swap_portable(in + i, out + i, (bytes - i) / width, width);
+    }
+#endif
+
+#ifdef ALS_UTILITIES_BYTE_ORDER_NEON
+    void swap_neon(const unsigned char* in, unsigned char* out, const size_t count, const size_t width)
+    {
+        const size_t bytes = count * width;
+        size_t i = 0;
+        for (; i + 16 <= bytes; i += 16)
+        {
+            const uint8x16_t block = vld1q_u8(in + i);
+            vst1q_u8(out + i, width == 2 ? vrev16q_u8(block) : width == 4 ? vrev32q_u8(block) : vrev64q_u8(block));
+        }
+        swap_portable(in + i, out + i, (bytes - i) / width, width);
+    }
+#endif
+
+    using SwapFunction = void (*)(const unsigned char*, unsigned char*, size_t, size_t);
+
+    SwapFunction select_swap()
+    {
+#ifdef ALS_UTILITIES_BYTE_ORDER_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return swap_avx2;
+        }
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            return swap_ssse3;
+        }
+#endif
+#ifdef ALS_UTILITIES_BYTE_ORDER_NEON
+        return swap_neon;
+#else
+        return swap_portable;
+#endif
+    }
+}
+
+void als::utilities::swap_bytes(const void* input, void* output, const size_t count, const size_t width)
+{
+    static const SwapFunction function = select_swap();
+    if (width != 1 && width != 2 && width != 4 && width != 8)
+    {
+        throw std::invalid_argument("swap_bytes: the width must be 1, 2, 4 or 8 bytes.");
+    }
+    const unsigned char* in = static_cast<const unsigned char*>(input);
+    unsigned char* out = static_cast<unsigned char*>(output);
+    if (width == 1)
+    {
+        if (in != out)
+        {
+            std::memcpy(out, in, count);
+        }
+        return;
+    }
+    function(in, out, count, width);
+}
+
+#endif // ALS_UTILITIES_BYTE_ORDER_CPP
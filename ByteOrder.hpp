@@ -0,0 +1,85 @@
+/** 
+ * @file ByteOrder.hpp
+ * @brief This file contains functions to reverse the byte order of numbers
+ * and of whole arrays of numbers.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * @a byte_swap reverses the bytes of a single number, whereas @a swap_bytes
+ * reverses the bytes of every element of an array. On x86-64 processors, the
+ * latter shuffles 32 bytes at a time with AVX2 or 16 bytes at a time with
+ * SSSE3, depending on what the processor supports; on AArch64, 16 bytes at a
+ * time with NEON. Elsewhere, a portable loop is used.
+ * 
+ * They are used by @a write_to_file and @a read_from_file to convert the data
+ * of archives written with a different byte order (see Archive.hpp).
+ */
+
+#ifndef ALS_UTILITIES_BYTE_ORDER_HPP
+#define ALS_UTILITIES_BYTE_ORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+#include <type_traits>
+
+namespace als::utilities
+{
+    /**
+     * @brief Returns a number with its bytes in the opposite order.
+     * 
+     * @tparam T an arithmetic type of 1, 2, 4 or 8 bytes.
+     * @param value
+     * @return T
+     */
+    template <class T>
+    T inline byte_swap(const T value)
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "byte_swap requires a number.");
+        if constexpr (sizeof(T) == 1)
+        {
+            return value;
+        }
+        else if constexpr (sizeof(T) == 2)
+        {
+            return std::bit_cast<T>(__builtin_bswap16(std::bit_cast<std::uint16_t>(value)));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return std::bit_cast<T>(__builtin_bswap32(std::bit_cast<std::uint32_t>(value)));
+        }
+        else
+        {
+            static_assert(sizeof(T) == 8, "byte_swap requires a number of 1, 2, 4 or 8 bytes.");
+            return std::bit_cast<T>(__builtin_bswap64(std::bit_cast<std::uint64_t>(value)));
+        }
+    }
+
+    /**
+     * @brief Reverses the bytes of each of the count elements of an array. The
+     * input and the output can be the same buffer, but they cannot overlap otherwise.
+     * Throws std::invalid_argument if width is not 1, 2, 4 or 8.
+     * 
+     * @param input
+     * @param output buffer of count * width bytes.
+     * @param count number of elements.
+     * @param width size in bytes of each element.
+     */
+    void swap_bytes(const void* input, void* output, const size_t count, const size_t width);
+
+    /**
+     * @brief Reverses the bytes of each of the count elements of an array in place.
+     * 
+     * @param data
+     * @param count number of elements.
+     * @param width size in bytes of each element (1, 2, 4 or 8).
+     */
+    void inline swap_bytes(void* data, const size_t count, const size_t width)
+    {
+        swap_bytes(data, data, count, width);
+    }
+}
+
+#endif // ALS_UTILITIES_BYTE_ORDER_HPP
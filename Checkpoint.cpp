@@ -0,0 +1,146 @@
+#ifndef ALS_UTILITIES_CHECKPOINT_CPP
+#define ALS_UTILITIES_CHECKPOINT_CPP
+
+#include "Checkpoint.hpp"
+
+#include <cerrno>
+
+#include <algorithm>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+void als::utilities::sync_file(const int fd)
+{
+    while (fsync(fd) != 0)
+    {
+        if (errno != EINTR)
+        {
+            throw std::system_error(errno, std::generic_category(), "sync_file: fsync failed");
+        }
+    }
+}
+
+void als::utilities::preallocate_file(const int fd, const size_t bytes)
+{
+#ifdef __linux__
+    // The size is kept, so a wrong estimate does not leave zeros at the end of the file.
+    while (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, bytes) != 0)
+    {
+        if (errno == ENOSPC)
+        {
+            throw std::system_error(errno, std::generic_category(), "preallocate_file: fallocate failed");
+        }
+        if (errno != EINTR)
+        {
+            return;
+        }
+    }
+#else
+    (void) fd;
+    (void) bytes;
+#endif
+}
+
+void als::utilities::replace_file(const std::string& from, const std::string& to)
+{
+    if (std::rename(from.c_str(), to.c_str()) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "replace_file: cannot rename " + from);
+    }
+
+    // The rename itself is only durable once the directory has been synchronised.
+    const size_t slash = to.find_last_of('/');
+    const std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : to.substr(0, slash));
+    const int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "replace_file: cannot open " + directory);
+    }
+    try
+    {
+        sync_file(fd);
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+// CheckpointWriter.
+CheckpointWriter::CheckpointWriter(const size_t queue_size, const FileFormat& format)
+    : queue_size_(std::max<size_t>(queue_size, 1)), format_(format), busy_(false), stopping_(false)
+{
+    thread_ = std::thread(&CheckpointWriter::run, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    not_empty_.notify_one();
+    thread_.join();
+}
+
+void CheckpointWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+size_t CheckpointWriter::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + (busy_ ? 1 : 0);
+}
+
+std::future<void> CheckpointWriter::enqueue(std::packaged_task<void()> task)
+{
+    std::future<void> future = task.get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return queue_.size() < queue_size_; });
+        queue_.push_back(std::move(task));
+    }
+    not_empty_.notify_one();
+    return future;
+}
+
+void CheckpointWriter::run()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+            if (queue_.empty())
+            {
+                // Only reached when stopping, once every checkpoint has been written.
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+        not_full_.notify_one();
+
+        // Exceptions are stored in the future of the task.
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        idle_.notify_all();
+    }
+}
+
+#endif // ALS_UTILITIES_CHECKPOINT_CPP
@@ -0,0 +1,515 @@
+/** 
+ * @file Checkpoint.hpp
+ * @brief This file contains functions to write checkpoints atomically and a
+ * writer that writes them on a background thread.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * @a write_checkpoint saves an object in an archive (see Archive.hpp) with
+ * @a write_to_file . The archive is written to a temporary file, synchronised
+ * with the disk and renamed, so the previous checkpoint is replaced only once
+ * the new one is complete.
+ * 
+ * A @a CheckpointWriter does the same on a background thread, so that the
+ * computation goes on while the data reaches the disk. It takes a snapshot of
+ * the object, either a copy or whatever is moved into it, and returns a
+ * std::future that becomes ready once the checkpoint has been written, or
+ * holds the exception that made it fail:
+ * 
+ * CheckpointWriter writer;
+ * std::future<void> done = writer.write("state.bin", state);
+ * // ... keep modifying state ...
+ * done.get();
+ * 
+ * The writer holds at most a fixed number of pending checkpoints. Once there
+ * are that many, @a CheckpointWriter::write blocks until the oldest one starts
+ * being written, so memory stays bounded when the disk falls behind.
+ * 
+ * An @a IncrementalCheckpointWriter writes checkpoints of large vectors that only
+ * contain the chunks that changed since the previous checkpoint, and
+ * @a read_incremental_checkpoint restores them.
+ */
+
+#ifndef ALS_UTILITIES_CHECKPOINT_HPP
+#define ALS_UTILITIES_CHECKPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Archive.hpp"
+#include "Checksum.hpp"
+#include "FileOperations.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Flushes the data of a file to the disk with fsync.
+     * Throws std::system_error on failure.
+     * 
+     * @param fd
+     */
+    void sync_file(const int fd);
+
+    /**
+     * @brief Atomically replaces a file with another one with rename and
+     * synchronises the directory that contains it. Throws std::system_error on failure.
+     * 
+     * @param from
+     * @param to
+     */
+    void replace_file(const std::string& from, const std::string& to);
+
+    /**
+     * @brief Reserves disk space for the first bytes of a file, without changing
+     * its size, so that the file system does not have to extend it piece by piece
+     * while it is written. Throws std::system_error if the disk is full; file
+     * systems that cannot reserve space are left alone.
+     * 
+     * @param fd
+     * @param bytes
+     */
+    void preallocate_file(const int fd, const size_t bytes);
+
+    /**
+     * @brief Creates an archive with a function, replacing the file atomically:
+     * the data is written to path + ".tmp", synchronised with the disk and renamed.
+     * If something fails, the previous file is left untouched.
+     * 
+     * @tparam Function a callable object that takes a reference to an ArchiveSink<FdSink>.
+     * @param path
+     * @param format format of the archive.
+     * @param bytes expected size of the archive, header included, which is
+     * reserved beforehand (see @a preallocate_file ), or 0 if it is unknown.
+     * @param write
+     */
+    template <class Function>
+    void inline write_archive_atomically(const std::string& path, const FileFormat& format, const size_t bytes,
+        Function&& write)
+    {
+        const std::string temporary = path + ".tmp";
+        try
+        {
+            FdSink file(temporary);
+            if (bytes > 0)
+            {
+                preallocate_file(file.fd(), bytes);
+            }
+            ArchiveSink archive(file, format);
+            write(archive);
+            archive.flush();
+            sync_file(file.fd());
+        }
+        catch (...)
+        {
+            std::remove(temporary.c_str());
+            throw;
+        }
+        replace_file(temporary, path);
+    }
+
+    template <class Function>
+    void inline write_archive_atomically(const std::string& path, const FileFormat& format, Function&& write)
+    {
+        write_archive_atomically(path, format, 0, std::forward<Function>(write));
+    }
+
+    /**
+     * @brief Writes an object in an archive with @a write_to_file , replacing the
+     * file atomically (see @a write_archive_atomically ). The space of the file
+     * is reserved beforehand with @a serialized_size .
+     * 
+     * @tparam T
+     * @param path
+     * @param object
+     * @param format format of the archive.
+     */
+    template <class T>
+    void inline write_checkpoint(const std::string& path, const T& object, const FileFormat& format = FileFormat())
+    {
+        const size_t bytes = FILE_HEADER_SIZE + serialized_size(object, format);
+        write_archive_atomically(path, format, bytes, [&](ArchiveSink<FdSink>& archive)
+        {
+            write_to_file(object, archive);
+        });
+    }
+
+    /**
+     * @brief Reads an object saved with @a write_checkpoint .
+     * 
+     * @tparam T
+     * @param path
+     * @param object
+     */
+    template <class T>
+    void inline read_checkpoint(const std::string& path, T& object)
+    {
+        FdSource file(path);
+        ArchiveSource archive(file);
+        read_from_file(object, archive);
+    }
+
+    /**
+     * @brief Default number of pending checkpoints of a @a CheckpointWriter .
+     */
+    inline constexpr size_t DEFAULT_CHECKPOINT_QUEUE_SIZE = 2;
+
+    /**
+     * @brief Writes checkpoints on a background thread, one after another, in the
+     * order in which they are submitted.
+     * 
+     */
+    class CheckpointWriter
+    {
+    public:
+        /**
+         * @brief Construct a new Checkpoint Writer object and start its thread.
+         * 
+         * @param queue_size maximum number of checkpoints waiting to be written,
+         * not counting the one being written.
+         * @param format format of the archives.
+         */
+        explicit CheckpointWriter(const size_t queue_size = DEFAULT_CHECKPOINT_QUEUE_SIZE,
+            const FileFormat& format = FileFormat());
+
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        /**
+         * @brief Writes the pending checkpoints and stops the thread.
+         * 
+         */
+        ~CheckpointWriter();
+
+        /**
+         * @brief Writes a snapshot of an object with @a write_checkpoint on the
+         * background thread. The object is taken by value, so pass it with
+         * std::move to avoid copying it. Blocks while the queue is full.
+         * 
+         * @tparam T
+         * @param path
+         * @param object
+         * @return std::future<void> ready once the checkpoint has been written.
+         */
+        template <class T>
+        std::future<void> write(std::string path, T object)
+        {
+            return submit([path = std::move(path), object = std::move(object), format = format_]()
+            {
+                write_checkpoint(path, object, format);
+            });
+        }
+
+        /**
+         * @brief Runs a function on the background thread after the checkpoints
+         * submitted before it, for instance to write with other streams. Blocks
+         * while the queue is full.
+         * 
+         * @tparam Function a callable object without arguments.
+         * @param task
+         * @return std::future<void> ready once the function has returned.
+         */
+        template <class Function>
+        std::future<void> submit(Function&& task)
+        {
+            return enqueue(std::packaged_task<void()>(std::forward<Function>(task)));
+        }
+
+        /**
+         * @brief Waits until every checkpoint submitted so far has been written.
+         * 
+         */
+        void wait();
+
+        /**
+         * @brief Returns the number of checkpoints that have not been written yet,
+         * including the one being written.
+         * 
+         * @return size_t
+         */
+        size_t pending() const;
+
+    private:
+        std::future<void> enqueue(std::packaged_task<void()> task);
+        void run();
+
+        size_t queue_size_;
+        FileFormat format_;
+        mutable std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+        std::condition_variable idle_;
+        std::deque<std::packaged_task<void()>> queue_;
+        bool busy_;
+        bool stopping_;
+        std::thread thread_;
+    };
+
+    /**
+     * @brief Default size in bytes of the chunks of an @a IncrementalCheckpointWriter .
+     */
+    inline constexpr size_t DEFAULT_CHECKPOINT_CHUNK_SIZE = 1 << 20;
+
+    /**
+     * @brief Default number of deltas written by an @a IncrementalCheckpointWriter
+     * before it writes a full checkpoint again.
+     */
+    inline constexpr size_t DEFAULT_CHECKPOINT_CHAIN_LENGTH = 16;
+
+    /**
+     * @brief Returns the path of the i-th delta of an incremental checkpoint.
+     * 
+     * @param path path of the full checkpoint.
+     * @param i
+     * @return std::string
+     */
+    std::string inline checkpoint_delta_path(const std::string& path, const size_t i)
+    {
+        return path + "." + std::to_string(i);
+    }
+
+    /**
+     * @brief Writes checkpoints of a vector that only contain the chunks that
+     * changed since the previous checkpoint.
+     * 
+     * The vector is split into chunks of a fixed size, and the hash of each chunk
+     * (see @a hash64 ) is kept. The first checkpoint is full and is written to
+     * path; the following ones are deltas, written to path.1, path.2..., with the
+     * chunks whose hash changed. After a number of deltas, a full checkpoint is
+     * written again, so that restoring never reads too many files. Every file is
+     * replaced atomically (see @a write_archive_atomically ), and
+     * @a read_incremental_checkpoint merges the full checkpoint with its deltas.
+     * 
+     * Each file is an archive that contains: an identifier of the chain of deltas
+     * (64 bits), the position in the chain (64 bits, 0 for the full checkpoint),
+     * the number of elements N as any other size, the number of elements of each
+     * chunk (64 bits), a vector with the indices of the chunks in the file (64 bits
+     * each), and then the elements of those chunks.
+     * 
+     * @tparam T a bitwise serializable type.
+     */
+    template <class T>
+    class IncrementalCheckpointWriter
+    {
+        static_assert(is_bitwise_serializable_v<T>,
+            "IncrementalCheckpointWriter requires a bitwise serializable type.");
+
+    public:
+        /**
+         * @brief Construct a new Incremental Checkpoint Writer object. Nothing is
+         * written until @a write is called.
+         * 
+         * @param path path of the full checkpoint.
+         * @param chunk_size size of the chunks in bytes.
+         * @param chain_length number of deltas after which a full checkpoint is written.
+         * @param format format of the archives.
+         */
+        explicit IncrementalCheckpointWriter(std::string path, const size_t chunk_size = DEFAULT_CHECKPOINT_CHUNK_SIZE,
+            const size_t chain_length = DEFAULT_CHECKPOINT_CHAIN_LENGTH, const FileFormat& format = FileFormat())
+            : path_(std::move(path)), chunk_(std::max<size_t>(1, chunk_size / sizeof(T))),
+            chain_length_(chain_length), format_(format), chain_(0), deltas_(0), full_(false)
+        {
+        }
+
+        /**
+         * @brief Writes a checkpoint of a vector: a delta with the chunks that
+         * changed since the previous checkpoint or, if there is none or the chain
+         * of deltas is full, a full checkpoint.
+         * 
+         * @param object
+         * @return size_t number of chunks written.
+         */
+        size_t write(const std::vector<T>& object)
+        {
+            std::vector<std::uint64_t> hashes = chunk_hashes(object);
+            if (!full_ || deltas_ >= chain_length_)
+            {
+                write_full(object, std::move(hashes));
+                return hashes_.size();
+            }
+            std::vector<std::uint64_t> changed;
+            for (size_t i = 0; i < hashes.size(); i++)
+            {
+                if (i >= hashes_.size() || hashes[i] != hashes_[i])
+                {
+                    changed.push_back(i);
+                }
+            }
+            write_chunks(checkpoint_delta_path(path_, deltas_ + 1), chain_, deltas_ + 1, object, changed);
+            deltas_++;
+            hashes_ = std::move(hashes);
+            return changed.size();
+        }
+
+        /**
+         * @brief Writes a full checkpoint of a vector, which starts a new chain of deltas.
+         * 
+         * @param object
+         */
+        void write_full(const std::vector<T>& object)
+        {
+            write_full(object, chunk_hashes(object));
+        }
+
+        /**
+         * @brief Returns the number of deltas written since the last full checkpoint.
+         * 
+         * @return size_t
+         */
+        size_t deltas() const { return deltas_; }
+
+    private:
+        std::vector<std::uint64_t> chunk_hashes(const std::vector<T>& object) const
+        {
+            std::vector<std::uint64_t> hashes((object.size() + chunk_ - 1) / chunk_);
+            for (size_t i = 0; i < hashes.size(); i++)
+            {
+                const size_t length = std::min(chunk_, object.size() - i * chunk_);
+                hashes[i] = hash64(object.data() + i * chunk_, length * sizeof(T));
+            }
+            return hashes;
+        }
+
+        void write_full(const std::vector<T>& object, std::vector<std::uint64_t> hashes)
+        {
+            std::vector<std::uint64_t> all(hashes.size());
+            for (size_t i = 0; i < all.size(); i++)
+            {
+                all[i] = i;
+            }
+            std::random_device random;
+            const std::uint64_t chain = (static_cast<std::uint64_t>(random()) << 32) ^ random();
+            write_chunks(path_, chain, 0, object, all);
+            chain_ = chain;
+            full_ = true;
+            deltas_ = 0;
+            hashes_ = std::move(hashes);
+
+            // The deltas of the previous chain are stale. They would be ignored
+            // anyway, since their chain differs.
+            for (size_t i = 1; std::remove(checkpoint_delta_path(path_, i).c_str()) == 0; i++)
+            {
+            }
+        }
+
+        void write_chunks(const std::string& path, const std::uint64_t chain, const std::uint64_t position,
+            const std::vector<T>& object, const std::vector<std::uint64_t>& chunks) const
+        {
+            size_t bytes = FILE_HEADER_SIZE + 3 * sizeof(std::uint64_t) + serialized_size_width(format_)
+                + serialized_size(chunks, format_);
+            for (const std::uint64_t i : chunks)
+            {
+                bytes += std::min(chunk_, object.size() - i * chunk_) * serialized_element_size<T>(format_);
+            }
+            write_archive_atomically(path, format_, bytes, [&](ArchiveSink<FdSink>& archive)
+            {
+                const std::uint64_t chunk = chunk_;
+                write_to_file(chain, archive);
+                write_to_file(position, archive);
+                write_size_to_file(object.size(), archive);
+                write_to_file(chunk, archive);
+                write_to_file(chunks, archive);
+                for (const std::uint64_t i : chunks)
+                {
+                    write_array_to_file(object.data() + i * chunk_, std::min(chunk_, object.size() - i * chunk_), archive);
+                }
+            });
+        }
+
+        std::string path_;
+        size_t chunk_;
+        size_t chain_length_;
+        FileFormat format_;
+        std::uint64_t chain_;
+        size_t deltas_;
+        bool full_;
+        std::vector<std::uint64_t> hashes_;
+    };
+
+    /**
+     * @brief Reads a checkpoint written by an @a IncrementalCheckpointWriter : the
+     * full checkpoint at path, followed by its deltas in order. Deltas that belong
+     * to an older chain are ignored. Throws std::runtime_error if a file is malformed.
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param path path of the full checkpoint.
+     * @param object
+     * @return size_t number of deltas applied.
+     */
+    template <class T>
+    size_t inline read_incremental_checkpoint(const std::string& path, std::vector<T>& object)
+    {
+        std::uint64_t chain = 0;
+        std::uint64_t chunk = 0;
+        size_t deltas = 0;
+        for (size_t position = 0; ; position++)
+        {
+            const std::string file_path = (position == 0) ? path : checkpoint_delta_path(path, position);
+            if (position > 0 && !std::filesystem::exists(file_path))
+            {
+                return deltas;
+            }
+            FdSource file(file_path);
+            ArchiveSource archive(file);
+            std::uint64_t file_chain, file_position, file_chunk;
+            read_from_file(file_chain, archive);
+            read_from_file(file_position, archive);
+            const size_t N = read_size_from_file(archive);
+            read_from_file(file_chunk, archive);
+            if (position == 0)
+            {
+                chain = file_chain;
+                chunk = file_chunk;
+            }
+            if (file_chain != chain || file_position != position)
+            {
+                // A delta of an older chain.
+                return deltas;
+            }
+            if (file_chunk != chunk || chunk == 0)
+            {
+                throw std::runtime_error("read_incremental_checkpoint: invalid chunk size.");
+            }
+            std::vector<std::uint64_t> chunks;
+            read_from_file(chunks, archive);
+            const size_t count = (N + chunk - 1) / chunk;
+            if (position == 0)
+            {
+                if (chunks.size() != count)
+                {
+                    throw std::runtime_error("read_incremental_checkpoint: the full checkpoint is incomplete.");
+                }
+                read_array_from_file(object, N, archive);
+                continue;
+            }
+            object.resize(N);
+            for (size_t k = 0; k < chunks.size(); k++)
+            {
+                const std::uint64_t i = chunks[k];
+                if (i >= count || (k > 0 && i <= chunks[k - 1]))
+                {
+                    throw std::runtime_error("read_incremental_checkpoint: invalid chunk.");
+                }
+                read_array_from_file(object.data() + i * chunk, std::min<size_t>(chunk, N - i * chunk), archive);
+            }
+            deltas++;
+        }
+    }
+}
+
+#endif // ALS_UTILITIES_CHECKPOINT_HPP
@@ -0,0 +1,357 @@
+#ifndef ALS_UTILITIES_CHECKSUM_CPP
+#define ALS_UTILITIES_CHECKSUM_CPP
+
+#include "Checksum.hpp"
+
+#include <bit>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define ALS_UTILITIES_CRC32C_SSE42
+#endif
+
+using namespace als::utilities;
+
+namespace
+{
+    // CRC32C polynomial, bit-reversed.
+    constexpr std::uint32_t POLYNOMIAL = 0x82f63b78;
+
+    // Tables for slicing-by-8: table[k][b] is the checksum of byte b followed by k zero bytes.
+    struct PortableTables
+    {
+        std::uint32_t table[8][256];
+
+        PortableTables()
+        {
+            for (std::uint32_t b = 0; b < 256; b++)
+            {
+                std::uint32_t crc = b;
+                for (int k = 0; k < 8; k++)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+                }
+                table[0][b] = crc;
+            }
+            for (std::uint32_t b = 0; b < 256; b++)
+            {
+                for (int k = 1; k < 8; k++)
+                {
+                    table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+                }
+            }
+        }
+    };
+
+    const PortableTables& portable_tables()
+    {
+        static const PortableTables tables;
+        return tables;
+    }
+
+#ifdef ALS_UTILITIES_CRC32C_SSE42
+    // The hardware version computes three lanes at the same time, which hides the
+    // latency of the crc32 instruction, and then combines them. Combining requires
+    // shifting a checksum over a fixed number of zero bytes, which is a linear
+    // operation computed with the tables below. This is Mark Adler's method.
+    constexpr size_t LONG_LANE = 8192;
+    constexpr size_t SHORT_LANE = 256;
+
+    std::uint32_t gf2_matrix_times(const std::uint32_t* matrix, std::uint32_t vector)
+    {
+        std::uint32_t sum = 0;
+        while (vector != 0)
+        {
+            if (vector & 1)
+            {
+                sum ^= *matrix;
+            }
+            vector >>= 1;
+            matrix++;
+        }
+        return sum;
+    }
+
+    void gf2_matrix_square(std::uint32_t* square, const std::uint32_t* matrix)
+    {
+        for (int n = 0; n < 32; n++)
+        {
+            square[n] = gf2_matrix_times(matrix, matrix[n]);
+        }
+    }
+
+    struct ShiftTable
+    {
+        std::uint32_t table[4][256];
+
+        // Table of the operator that appends bytes zero bytes to a checksum.
+        explicit ShiftTable(size_t bytes)
+        {
+            std::uint32_t even[32];
+            std::uint32_t odd[32];
+
+            // Operator for one zero bit.
+            odd[0] = POLYNOMIAL;
+            std::uint32_t row = 1;
+            for (int n = 1; n < 32; n++)
+            {
+                odd[n] = row;
+                row <<= 1;
+            }
+            gf2_matrix_square(even, odd);  // Two zero bits.
+            gf2_matrix_square(odd, even);  // Four zero bits.
+
+            // Each squaring doubles the number of zero bits, starting from one byte.
+            const std::uint32_t* op;
+            while (true)
+            {
+                gf2_matrix_square(even, odd);
+                bytes >>= 1;
+                if (bytes == 0)
+                {
+                    op = even;
+                    break;
+                }
+                gf2_matrix_square(odd, even);
+                bytes >>= 1;
+                if (bytes == 0)
+                {
+                    op = odd;
+                    break;
+                }
+            }
+
+            for (std::uint32_t n = 0; n < 256; n++)
+            {
+                table[0][n] = gf2_matrix_times(op, n);
+                table[1][n] = gf2_matrix_times(op, n << 8);
+                table[2][n] = gf2_matrix_times(op, n << 16);
+                table[3][n] = gf2_matrix_times(op, n << 24);
+            }
+        }
+
+        std::uint32_t shift(const std::uint32_t crc) const
+        {
+            return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff]
+                ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+        }
+    };
+
+    const ShiftTable& long_shift()
+    {
+        static const ShiftTable table(LONG_LANE);
+        return table;
+    }
+
+    const ShiftTable& short_shift()
+    {
+        static const ShiftTable table(SHORT_LANE);
+        return table;
+    }
+
+    std::uint64_t load64(const unsigned char* p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    template <size_t LANE>
+    __attribute__((target("sse4.2")))
+    std::uint64_t crc32c_lanes(std::uint64_t crc0, const unsigned char*& next, size_t& bytes,
+        const ShiftTable& shift)
+    {
+        while (bytes >= 3 * LANE)
+        {
+            std::uint64_t crc1 = 0;
+            std::uint64_t crc2 = 0;
+            const unsigned char* const end = next + LANE;
+            do
+            {
+                crc0 = _mm_crc32_u64(crc0, load64(next));
+                crc1 = _mm_crc32_u64(crc1, load64(next + LANE));
+                crc2 = _mm_crc32_u64(crc2, load64(next + 2 * LANE));
+                next += 8;
+            } while (next < end);
+            crc0 = shift.shift(static_cast<std::uint32_t>(crc0)) ^ crc1;
+            crc0 = shift.shift(static_cast<std::uint32_t>(crc0)) ^ crc2;
+            next += 2 * LANE;
+            bytes -= 3 * LANE;
+        }
+        return crc0;
+    }
+
+    __attribute__((target("sse4.2")))
+    std::uint32_t crc32c_sse42(const void* data, size_t bytes, const std::uint32_t crc)
+    {
+        const unsigned char* next = static_cast<const unsigned char*>(data);
+        std::uint64_t crc0 = crc ^ 0xffffffffu;
+        while (bytes > 0 && (reinterpret_cast<std::uintptr_t>(next) & 7) != 0)
+        {
+            crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *next++);
+            bytes--;
+        }
+        crc0 = crc32c_lanes<LONG_LANE>(crc0, next, bytes, long_shift());
+        crc0 = crc32c_lanes<SHORT_LANE>(crc0, next, bytes, short_shift());
+        while (bytes >= 8)
+        {
+            crc0 = _mm_crc32_u64(crc0, load64(next));
+            next += 8;
+            bytes -= 8;
+        }
+        while (bytes > 0)
+        {
+            crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *next++);
+            bytes--;
+        }
+        return static_cast<std::uint32_t>(crc0) ^ 0xffffffffu;
+    }
+#endif
+
+    using Crc32cFunction = std::uint32_t (*)(const void*, size_t, std::uint32_t);
+
+    Crc32cFunction select_crc32c()
+    {
+#ifdef ALS_UTILITIES_CRC32C_SSE42
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            // The tables are built now, so that the first checksum is not slower.
+            long_shift();
+            short_shift();
+            return crc32c_sse42;
+        }
+#endif
+        portable_tables();
+        return crc32c_portable;
+    }
+}
+
+std::uint32_t als::utilities::crc32c_portable(const void* data, size_t bytes, const std::uint32_t crc)
+{
+    const auto& table = portable_tables().table;
+    const unsigned char* next = static_cast<const unsigned char*>(data);
+    std::uint32_t c = crc ^ 0xffffffffu;
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        while (bytes >= 8)
+        {
+            std::uint32_t low, high;
+            std::memcpy(&low, next, 4);
+            std::memcpy(&high, next + 4, 4);
+            low ^= c;
+            c = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^ table[5][(low >> 16) & 0xff]
+                ^ table[4][low >> 24] ^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff]
+                ^ table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+            next += 8;
+            bytes -= 8;
+        }
+    }
+    while (bytes > 0)
+    {
+        c = (c >> 8) ^ table[0][(c ^ *next++) & 0xff];
+        bytes--;
+    }
+    return c ^ 0xffffffffu;
+}
+
+namespace
+{
+    // Constants of XXH64.
+    constexpr std::uint64_t PRIME1 = 0x9e3779b185ebca87ULL;
+    constexpr std::uint64_t PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+    constexpr std::uint64_t PRIME3 = 0x165667b19e3779f9ULL;
+    constexpr std::uint64_t PRIME4 = 0x85ebca77c2b2ae63ULL;
+    constexpr std::uint64_t PRIME5 = 0x27d4eb2f165667c5ULL;
+
+    std::uint64_t load_le64(const unsigned char* p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (std::endian::native == std::endian::little) ? v : __builtin_bswap64(v);
+    }
+
+    std::uint32_t load_le32(const unsigned char* p)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (std::endian::native == std::endian::little) ? v : __builtin_bswap32(v);
+    }
+
+    std::uint64_t xxh64_round(std::uint64_t acc, const std::uint64_t input)
+    {
+        acc += input * PRIME2;
+        acc = std::rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    std::uint64_t xxh64_merge(std::uint64_t acc, const std::uint64_t lane)
+    {
+        acc ^= xxh64_round(0, lane);
+        return acc * PRIME1 + PRIME4;
+    }
+}
+
+std::uint64_t als::utilities::hash64(const void* data, const size_t bytes, const std::uint64_t seed)
+{
+    const unsigned char* next = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = next + bytes;
+    std::uint64_t h;
+    if (bytes >= 32)
+    {
+        // Four independent lanes, so that the multiplications overlap.
+        std::uint64_t v1 = seed + PRIME1 + PRIME2;
+        std::uint64_t v2 = seed + PRIME2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - PRIME1;
+        do
+        {
+            v1 = xxh64_round(v1, load_le64(next));
+            v2 = xxh64_round(v2, load_le64(next + 8));
+            v3 = xxh64_round(v3, load_le64(next + 16));
+            v4 = xxh64_round(v4, load_le64(next + 24));
+            next += 32;
+        } while (end - next >= 32);
+        h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME5;
+    }
+    h += bytes;
+
+    for (; end - next >= 8; next += 8)
+    {
+        h ^= xxh64_round(0, load_le64(next));
+        h = std::rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (end - next >= 4)
+    {
+        h ^= load_le32(next) * PRIME1;
+        h = std::rotl(h, 23) * PRIME2 + PRIME3;
+        next += 4;
+    }
+    for (; next < end; next++)
+    {
+        h ^= *next * PRIME5;
+        h = std::rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::uint32_t als::utilities::crc32c(const void* data, const size_t bytes, const std::uint32_t crc)
+{
+    static const Crc32cFunction function = select_crc32c();
+    return function(data, bytes, crc);
+}
+
+#endif // ALS_UTILITIES_CHECKSUM_CPP
@@ -0,0 +1,385 @@
+/** 
+ * @file Checksum.hpp
+ * @brief This file contains CRC32C checksums and streams that split the data
+ * into checksummed frames.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * @a crc32c computes the CRC32C (Castagnoli) checksum of a buffer. On x86-64
+ * processors with SSE4.2 it uses the crc32 instruction on three interleaved
+ * lanes; elsewhere, a portable table-driven implementation. @a hash64 computes
+ * a 64-bit hash, which is used to detect changed data (see Checkpoint.hpp).
+ * 
+ * A @a FramedSink splits the data written to it into frames of at most
+ * @a DEFAULT_FRAME_SIZE bytes, each preceded by its length and its checksum, and a
+ * @a FramedSource checks every frame while reading it. Thus, truncated or
+ * corrupted data throws std::runtime_error instead of being read silently:
+ * 
+ * FdSink file("checkpoint.bin");
+ * FramedSink framed(file);
+ * ArchiveSink archive(framed);
+ * write_to_file(object, archive);
+ * 
+ * The framed data starts with FRAME_MAGIC and the frame size (32 bits),
+ * followed by the frames. Each frame starts with the length of its payload and
+ * the checksum of the payload (32 bits each). An empty frame marks the end of
+ * the data.
+ */
+
+#ifndef ALS_UTILITIES_CHECKSUM_HPP
+#define ALS_UTILITIES_CHECKSUM_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Returns the CRC32C checksum of a buffer. Checksums can be computed
+     * piece by piece: crc32c(b, m, crc32c(a, n)) is the checksum of a followed by b.
+     * 
+     * @param data
+     * @param bytes
+     * @param crc checksum of the preceding data.
+     * @return std::uint32_t
+     */
+    std::uint32_t crc32c(const void* data, const size_t bytes, const std::uint32_t crc = 0);
+
+    /**
+     * @brief Portable implementation of @a crc32c , which does not use special
+     * instructions.
+     * 
+     * @param data
+     * @param bytes
+     * @param crc checksum of the preceding data.
+     * @return std::uint32_t
+     */
+    std::uint32_t crc32c_portable(const void* data, const size_t bytes, const std::uint32_t crc = 0);
+
+    /**
+     * @brief Returns a 64-bit hash of a buffer, suitable to detect changes in
+     * data but not against deliberate collisions. This is the XXH64 algorithm,
+     * which processes four independent 64-bit lanes.
+     * 
+     * @param data
+     * @param bytes
+     * @param seed
+     * @return std::uint64_t
+     */
+    std::uint64_t hash64(const void* data, const size_t bytes, const std::uint64_t seed = 0);
+
+    /**
+     * @brief Default size in bytes of the frames of a @a FramedSink .
+     */
+    inline constexpr size_t DEFAULT_FRAME_SIZE = 1 << 18;
+
+    /**
+     * @brief Largest frame size accepted by a @a FramedSource .
+     */
+    inline constexpr size_t MAX_FRAME_SIZE = 1 << 26;
+
+    /**
+     * @brief Magic number at the beginning of framed data.
+     */
+    inline constexpr unsigned char FRAME_MAGIC[4] = {'A', 'L', 'S', 'F'};
+
+    /**
+     * @brief Sink that splits the data written to it into checksummed frames
+     * and forwards them to another sink.
+     * 
+     * The end of the data is written by @a close or by the destructor.
+     * 
+     * @tparam Sink a FILE pointer or a sink.
+     */
+    template <class Sink>
+    class FramedSink
+    {
+    public:
+        /**
+         * @brief Construct a new Framed Sink object and write the magic number.
+         * 
+         * @param sink
+         * @param frame_size maximum size in bytes of the payload of a frame.
+         */
+        explicit FramedSink(stream_reference_t<Sink> sink, const size_t frame_size = DEFAULT_FRAME_SIZE)
+            : sink_(sink), frame_size_(frame_size), position_(0), used_(0), closed_(false)
+        {
+            if (frame_size_ == 0 || frame_size_ > MAX_FRAME_SIZE)
+            {
+                throw std::invalid_argument("FramedSink: invalid frame size.");
+            }
+            frame_.reset(new std::byte[frame_size_]);
+            const std::uint32_t size = frame_size_;
+            write_bytes(sink_, FRAME_MAGIC, sizeof(FRAME_MAGIC));
+            write_bytes(sink_, &size, sizeof(size));
+        }
+
+        FramedSink(const FramedSink&) = delete;
+        FramedSink& operator=(const FramedSink&) = delete;
+
+        /**
+         * @brief Closes the sink if it has not been closed yet. Errors can only
+         * be detected by calling @a close beforehand.
+         * 
+         */
+        ~FramedSink()
+        {
+            if (!closed_)
+            {
+                try
+                {
+                    close();
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+
+        void write(const void* data, size_t bytes)
+        {
+            const std::byte* source = static_cast<const std::byte*>(data);
+            while (bytes > 0)
+            {
+                if (used_ == 0 && bytes >= frame_size_)
+                {
+                    // Whole frames are checksummed and written without copying them.
+                    write_frame(source, frame_size_);
+                    source += frame_size_;
+                    bytes -= frame_size_;
+                    continue;
+                }
+                const size_t n = std::min(bytes, frame_size_ - used_);
+                std::memcpy(frame_.get() + used_, source, n);
+                used_ += n;
+                source += n;
+                bytes -= n;
+                if (used_ == frame_size_)
+                {
+                    end_frame();
+                }
+            }
+        }
+
+        /**
+         * @brief Ends the current frame and flushes the underlying sink.
+         * 
+         */
+        void flush()
+        {
+            end_frame();
+            flush_stream(sink_);
+        }
+
+        size_t tell() const { return position_ + used_; }
+
+        /**
+         * @brief Overwrites data of the current frame. Throws std::out_of_range
+         * if the data belongs to a frame that has already been written.
+         * 
+         * @param offset
+         * @param data
+         * @param bytes
+         */
+        void patch(const size_t offset, const void* data, const size_t bytes)
+        {
+            if (offset < position_ || offset + bytes > position_ + used_)
+            {
+                throw std::out_of_range("FramedSink: the frame has already been written.");
+            }
+            std::memcpy(frame_.get() + (offset - position_), data, bytes);
+        }
+
+        /**
+         * @brief Writes whatever has been written so far as a frame, without
+         * flushing the underlying sink. Records that end a frame can be
+         * recovered even if later frames are lost.
+         * 
+         */
+        void end_frame()
+        {
+            if (used_ > 0)
+            {
+                write_frame(frame_.get(), used_);
+                used_ = 0;
+            }
+        }
+
+        /**
+         * @brief Ends the current frame and writes the end of the data.
+         * Nothing can be written afterwards.
+         * 
+         */
+        void close()
+        {
+            end_frame();
+            const std::uint32_t end[2] = {0, 0};
+            write_bytes(sink_, end, sizeof(end));
+            flush_stream(sink_);
+            closed_ = true;
+        }
+
+    private:
+        void write_frame(const std::byte* payload, const size_t bytes)
+        {
+            const std::uint32_t header[2] = {static_cast<std::uint32_t>(bytes), crc32c(payload, bytes)};
+            write_bytes(sink_, header, sizeof(header));
+            write_bytes(sink_, payload, bytes);
+            position_ += bytes;
+        }
+
+        stream_reference_t<Sink> sink_;
+        size_t frame_size_;
+        std::unique_ptr<std::byte[]> frame_;
+        size_t position_;
+        size_t used_;
+        bool closed_;
+    };
+
+    template <class Sink>
+    FramedSink(Sink&) -> FramedSink<Sink>;
+
+    template <class Sink>
+    FramedSink(Sink&, size_t) -> FramedSink<Sink>;
+
+    FramedSink(FILE*) -> FramedSink<FILE*>;
+
+    FramedSink(FILE*, size_t) -> FramedSink<FILE*>;
+
+    /**
+     * @brief Source that reads the data written by a @a FramedSink and checks
+     * the checksum of every frame before handing out any of its bytes.
+     * Throws std::runtime_error if a frame is corrupted or the data ends prematurely.
+     * 
+     * @tparam Source a FILE pointer or a source.
+     */
+    template <class Source>
+    class FramedSource
+    {
+    public:
+        /**
+         * @brief Construct a new Framed Source object and read the magic number.
+         * 
+         * @param source
+         */
+        explicit FramedSource(stream_reference_t<Source> source)
+            : source_(source), position_(0), begin_(0), end_(0), finished_(false)
+        {
+            unsigned char magic[sizeof(FRAME_MAGIC)];
+            std::uint32_t size;
+            read_bytes(source_, magic, sizeof(magic));
+            read_bytes(source_, &size, sizeof(size));
+            if (std::memcmp(magic, FRAME_MAGIC, sizeof(magic)) != 0)
+            {
+                throw std::runtime_error("FramedSource: the data is not framed.");
+            }
+            if (size == 0 || size > MAX_FRAME_SIZE)
+            {
+                throw std::runtime_error("FramedSource: invalid frame size.");
+            }
+            frame_size_ = size;
+            frame_.reset(new std::byte[frame_size_]);
+        }
+
+        void read(void* data, size_t bytes)
+        {
+            std::byte* destination = static_cast<std::byte*>(data);
+            while (bytes > 0)
+            {
+                if (begin_ == end_)
+                {
+                    // Frames that fit in the destination are read straight into it.
+                    const size_t length = read_header();
+                    if (length <= bytes)
+                    {
+                        read_payload(destination, length);
+                        destination += length;
+                        bytes -= length;
+                        continue;
+                    }
+                    read_payload(frame_.get(), length);
+                    begin_ = 0;
+                    end_ = length;
+                }
+                const size_t n = std::min(bytes, end_ - begin_);
+                std::memcpy(destination, frame_.get() + begin_, n);
+                begin_ += n;
+                destination += n;
+                bytes -= n;
+            }
+        }
+
+        void skip(size_t bytes)
+        {
+            while (bytes > 0)
+            {
+                if (begin_ == end_)
+                {
+                    const size_t length = read_header();
+                    read_payload(frame_.get(), length);
+                    begin_ = 0;
+                    end_ = length;
+                }
+                const size_t n = std::min(bytes, end_ - begin_);
+                begin_ += n;
+                bytes -= n;
+            }
+        }
+
+        size_t tell() const { return position_ - (end_ - begin_); }
+
+    private:
+        size_t read_header()
+        {
+            if (!finished_)
+            {
+                read_bytes(source_, header_, sizeof(header_));
+            }
+            if (finished_ || header_[0] == 0)
+            {
+                finished_ = true;
+                throw EndOfData("FramedSource: unexpected end of data.");
+            }
+            if (header_[0] > frame_size_)
+            {
+                throw std::runtime_error("FramedSource: invalid frame.");
+            }
+            return header_[0];
+        }
+
+        void read_payload(std::byte* destination, const size_t length)
+        {
+            read_bytes(source_, destination, length);
+            if (crc32c(destination, length) != header_[1])
+            {
+                throw std::runtime_error("FramedSource: checksum mismatch.");
+            }
+            position_ += length;
+        }
+
+        stream_reference_t<Source> source_;
+        size_t frame_size_;
+        std::unique_ptr<std::byte[]> frame_;
+        std::uint32_t header_[2];
+        size_t position_;
+        size_t begin_;
+        size_t end_;
+        bool finished_;
+    };
+
+    template <class Source>
+    FramedSource(Source&) -> FramedSource<Source>;
+
+    FramedSource(FILE*) -> FramedSource<FILE*>;
+}
+
+#endif // ALS_UTILITIES_CHECKSUM_HPP
@@ -0,0 +1,368 @@
+/** 
+ * @file ChunkedVectors.hpp
+ * @brief This file contains classes to write and read vectors piece by piece.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A @a ChunkedVectorWriter writes the elements of a vector as they are
+ * produced, so the whole vector never needs to be in memory. When it is closed,
+ * it goes back and writes the number of elements, so the result can be read
+ * with @a read_from_file as any other std::vector. Conversely, a
+ * @a ChunkedVectorReader reads a vector saved with @a write_to_file a few
+ * elements at a time.
+ * 
+ * In archives (see Archive.hpp), vectors of numbers are always written
+ * without encoding by a @a ChunkedVectorWriter , and a @a ChunkedVectorReader
+ * can only read such vectors. Vectors of strings in archives of version 3 or
+ * later are split into blocks (see @a has_batched_strings ), so a
+ * @a ChunkedVectorWriter keeps the strings of the current block in memory until
+ * it is full, and a @a ChunkedVectorReader reads the sizes of a block at once.
+ */
+
+#ifndef ALS_UTILITIES_CHUNKED_VECTORS_HPP
+#define ALS_UTILITIES_CHUNKED_VECTORS_HPP
+
+#include <cstdio>
+#include <cstddef>
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "FileOperations.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Writes a std::vector<T> one element or one batch at a time.
+     * 
+     * @tparam T
+     * @tparam Stream a FILE pointer or a sink with the method patch (see Streams.hpp).
+     */
+    template <class T, class Stream = FILE*>
+    class ChunkedVectorWriter
+    {
+    public:
+        using stream_type = stream_reference_t<Stream>;
+
+        /**
+         * @brief Construct a new Chunked Vector Writer object. A placeholder for the
+         * number of elements is written at the current position of the stream.
+         * 
+         * @param stream
+         */
+        explicit ChunkedVectorWriter(stream_type stream)
+            : stream_(stream), start_(stream_position(stream_)), size_(0), closed_(false), batched_(false)
+        {
+            if (start_ < 0)
+            {
+                throw std::runtime_error("ChunkedVectorWriter: the position of the stream is unknown.");
+            }
+            write_size_to_file(0, stream_);
+            if constexpr (is_char_string_v<T>)
+            {
+                batched_ = has_batched_strings(stream_);
+            }
+            if constexpr (has_encoding_tag_v<T>)
+            {
+                if (has_encoding_tags(stream_))
+                {
+                    const Encoding encoding = Encoding::RAW;
+                    write_bytes(stream_, &encoding, 1);
+                }
+            }
+        }
+
+        ChunkedVectorWriter(const ChunkedVectorWriter&) = delete;
+        ChunkedVectorWriter& operator=(const ChunkedVectorWriter&) = delete;
+
+        /**
+         * @brief Closes the writer if it has not been closed yet. Errors can only
+         * be detected by calling @a close beforehand.
+         * 
+         */
+        ~ChunkedVectorWriter()
+        {
+            if (!closed_)
+            {
+                try
+                {
+                    close();
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+
+        /**
+         * @brief Appends an element.
+         * 
+         * @param element
+         */
+        void push_back(const T& element)
+        {
+            if constexpr (is_char_string_v<T>)
+            {
+                if (batched_)
+                {
+                    push_string(element);
+                    size_++;
+                    return;
+                }
+            }
+            write_to_file(element, stream_);
+            size_++;
+        }
+
+        /**
+         * @brief Appends a batch of elements.
+         * 
+         * @param batch
+         */
+        void append(std::span<const T> batch)
+        {
+            if constexpr (is_char_string_v<T>)
+            {
+                if (batched_)
+                {
+                    for (const T& element : batch)
+                    {
+                        push_back(element);
+                    }
+                    return;
+                }
+            }
+            if constexpr (is_bitwise_serializable_v<T>)
+            {
+                write_array_to_file(batch.data(), batch.size(), stream_);
+            }
+            else
+            {
+                for (const T& element : batch)
+                {
+                    write_to_file(element, stream_);
+                }
+            }
+            size_ += batch.size();
+        }
+
+        /**
+         * @brief Writes the strings kept in memory, if any, and the number of
+         * elements at the beginning of the vector. No element can be appended afterwards.
+         * 
+         */
+        void close()
+        {
+            if (batched_)
+            {
+                write_block();
+            }
+            if (stream_format(stream_).size_width == 8)
+            {
+                const std::uint64_t size = has_swapped_byte_order(stream_) ? byte_swap<std::uint64_t>(size_) : size_;
+                patch_bytes(stream_, start_, &size, sizeof(size));
+            }
+            else
+            {
+                if (size_ > UINT32_MAX)
+                {
+                    throw std::length_error("ChunkedVectorWriter: the size does not fit in 32 bits.");
+                }
+                const std::uint32_t size = has_swapped_byte_order(stream_) ? byte_swap<std::uint32_t>(size_) : size_;
+                patch_bytes(stream_, start_, &size, sizeof(size));
+            }
+            closed_ = true;
+        }
+
+        /**
+         * @brief Returns the number of elements written so far.
+         * 
+         * @return size_t
+         */
+        size_t size() const { return size_; }
+
+    private:
+        // Follows the blocks of write_to_file, so that the result is the same.
+        void push_string(const T& element)
+        {
+            const size_t width = stream_format(stream_).size_width == 8 ? 8 : 4;
+            const size_t bytes = sizes_.size() * width + characters_.size();
+            if (!sizes_.empty() && bytes + width + element.size() > FILE_OPERATIONS_CHUNK_SIZE)
+            {
+                write_block();
+            }
+            if (sizes_.empty() && width + element.size() > FILE_OPERATIONS_CHUNK_SIZE)
+            {
+                // Long strings take a block of their own and are written in place.
+                const std::uint64_t size = element.size();
+                write_string_block(&size, 1, element.data(), element.size(), stream_);
+                return;
+            }
+            sizes_.push_back(element.size());
+            characters_.append(element.data(), element.size());
+        }
+
+        void write_block()
+        {
+            if (!sizes_.empty())
+            {
+                write_string_block(sizes_.data(), sizes_.size(), characters_.data(), characters_.size(), stream_);
+                sizes_.clear();
+                characters_.clear();
+            }
+        }
+
+        stream_type stream_;
+        long start_;
+        size_t size_;
+        bool closed_;
+
+        // Strings of the current block of archives with batched strings.
+        bool batched_;
+        std::vector<std::uint64_t> sizes_;
+        std::string characters_;
+    };
+
+    /**
+     * @brief Reads a std::vector<T> saved with @a write_to_file one element
+     * or one batch at a time.
+     * 
+     * @tparam T
+     * @tparam Stream a FILE pointer or a source (see Streams.hpp).
+     */
+    template <class T, class Stream = FILE*>
+    class ChunkedVectorReader
+    {
+    public:
+        using stream_type = stream_reference_t<Stream>;
+
+        /**
+         * @brief Construct a new Chunked Vector Reader object. The number of elements
+         * is read from the current position of the stream.
+         * 
+         * @param stream
+         */
+        explicit ChunkedVectorReader(stream_type stream)
+            : stream_(stream), size_(0), read_(0), batched_(false), block_read_(0)
+        {
+            size_ = read_size_from_file(stream_);
+            if constexpr (is_char_string_v<T>)
+            {
+                batched_ = has_batched_strings(stream_);
+            }
+            if constexpr (has_encoding_tag_v<T>)
+            {
+                Encoding encoding = Encoding::RAW;
+                if (has_encoding_tags(stream_))
+                {
+                    read_bytes(stream_, &encoding, 1);
+                }
+                if (encoding != Encoding::RAW)
+                {
+                    throw std::runtime_error("ChunkedVectorReader: the vector is encoded.");
+                }
+            }
+        }
+
+        /**
+         * @brief Reads the next element. Returns false if there are none left.
+         * 
+         * @param element
+         * @return true
+         * @return false
+         */
+        bool next(T& element)
+        {
+            if (read_ == size_)
+            {
+                return false;
+            }
+            if constexpr (is_char_string_v<T>)
+            {
+                if (batched_)
+                {
+                    if (block_read_ == sizes_.size())
+                    {
+                        read_string_block_sizes(sizes_, remaining(), stream_);
+                        block_read_ = 0;
+                    }
+                    element.resize(sizes_[block_read_++]);
+                    read_bytes(stream_, element.data(), element.size());
+                    read_++;
+                    return true;
+                }
+            }
+            read_from_file(element, stream_);
+            read_++;
+            return true;
+        }
+
+        /**
+         * @brief Reads the next elements into a batch, until it is full or
+         * there are no elements left.
+         * 
+         * @param batch
+         * @return size_t number of elements read.
+         */
+        size_t read(std::span<T> batch)
+        {
+            const size_t N = std::min(batch.size(), remaining());
+            if constexpr (is_char_string_v<T>)
+            {
+                if (batched_)
+                {
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        next(batch[i]);
+                    }
+                    return N;
+                }
+            }
+            if constexpr (is_bitwise_serializable_v<T>)
+            {
+                read_array_from_file(batch.data(), N, stream_);
+            }
+            else
+            {
+                for (size_t i = 0; i < N; i++)
+                {
+                    read_from_file(batch[i], stream_);
+                }
+            }
+            read_ += N;
+            return N;
+        }
+
+        /**
+         * @brief Returns the total number of elements of the vector.
+         * 
+         * @return size_t
+         */
+        size_t size() const { return size_; }
+
+        /**
+         * @brief Returns the number of elements that have not been read yet.
+         * 
+         * @return size_t
+         */
+        size_t remaining() const { return size_ - read_; }
+
+    private:
+        stream_type stream_;
+        size_t size_;
+        size_t read_;
+
+        // Sizes of the strings of the current block of archives with batched strings.
+        bool batched_;
+        std::vector<std::uint64_t> sizes_;
+        size_t block_read_;
+    };
+}
+
+#endif // ALS_UTILITIES_CHUNKED_VECTORS_HPP
@@ -0,0 +1,209 @@
+#ifndef ALS_UTILITIES_COMPRESSION_CPP
+#define ALS_UTILITIES_COMPRESSION_CPP
+
+#include "Compression.hpp"
+
+#include <bit>
+
+using namespace als::utilities;
+
+namespace
+{
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;
+    constexpr size_t MATCH_FIND_LIMIT = 12;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr int HASH_BITS = 14;
+
+    std::uint32_t read32(const std::byte* p)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    std::uint64_t read64(const std::byte* p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    std::uint32_t hash(const std::uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Number of equal bytes at the beginning of a and b, up to limit.
+    size_t common_length(const std::byte* a, const std::byte* b, const std::byte* limit)
+    {
+        const std::byte* start = a;
+        while (a + 8 <= limit)
+        {
+            const std::uint64_t diff = read64(a) ^ read64(b);
+            if (diff != 0)
+            {
+                const int bits = (std::endian::native == std::endian::little) ? std::countr_zero(diff)
+                    : std::countl_zero(diff);
+                return (a - start) + bits / 8;
+            }
+            a += 8;
+            b += 8;
+        }
+        while (a < limit && *a == *b)
+        {
+            a++;
+            b++;
+        }
+        return a - start;
+    }
+
+    std::byte* write_length(std::byte* out, size_t length)
+    {
+        while (length >= 255)
+        {
+            *out++ = std::byte(255);
+            length -= 255;
+        }
+        *out++ = std::byte(length);
+        return out;
+    }
+
+    std::byte* write_sequence(std::byte* out, const std::byte* literals, const size_t literal_length,
+        const size_t offset, const size_t match_length)
+    {
+        std::byte* token = out++;
+        *token = std::byte(std::min<size_t>(literal_length, 15) << 4);
+        if (literal_length >= 15)
+        {
+            out = write_length(out, literal_length - 15);
+        }
+        std::memcpy(out, literals, literal_length);
+        out += literal_length;
+        if (match_length > 0)
+        {
+            *token |= std::byte(std::min<size_t>(match_length - MIN_MATCH, 15));
+            *out++ = std::byte(offset & 0xff);
+            *out++ = std::byte(offset >> 8);
+            if (match_length - MIN_MATCH >= 15)
+            {
+                out = write_length(out, match_length - MIN_MATCH - 15);
+            }
+        }
+        return out;
+    }
+
+    size_t read_length(const std::byte*& in, const std::byte* end, size_t length)
+    {
+        if (length == 15)
+        {
+            std::byte b;
+            do
+            {
+                if (in == end)
+                {
+                    throw std::runtime_error("decompress_block: truncated block.");
+                }
+                b = *in++;
+                length += static_cast<size_t>(b);
+            } while (b == std::byte(255));
+        }
+        return length;
+    }
+}
+
+size_t als::utilities::compress_block(const std::byte* input, const size_t size, std::byte* output)
+{
+    std::byte* out = output;
+    size_t anchor = 0;
+    if (size > MATCH_FIND_LIMIT)
+    {
+        // Positions are stored plus one, so that zero means empty.
+        std::unique_ptr<std::uint32_t[]> table(new std::uint32_t[1 << HASH_BITS]());
+        const size_t limit = size - MATCH_FIND_LIMIT;
+        const std::byte* match_limit = input + size - LAST_LITERALS;
+        size_t position = 0;
+        while (position < limit)
+        {
+            const std::uint32_t sequence = read32(input + position);
+            std::uint32_t& entry = table[hash(sequence)];
+            const size_t candidate = entry;
+            entry = position + 1;
+            if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(input + candidate - 1) != sequence)
+            {
+                // The further we are from the last match, the faster we move on.
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            size_t reference = candidate - 1;
+            while (position > anchor && reference > 0 && input[position - 1] == input[reference - 1])
+            {
+                position--;
+                reference--;
+            }
+            const size_t length = MIN_MATCH + common_length(input + position + MIN_MATCH,
+                input + reference + MIN_MATCH, match_limit);
+            out = write_sequence(out, input + anchor, position - anchor, position - reference, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    out = write_sequence(out, input + anchor, size - anchor, 0, 0);
+    return out - output;
+}
+
+size_t als::utilities::decompress_block(const std::byte* input, const size_t size, std::byte* output,
+    const size_t capacity)
+{
+    const std::byte* in = input;
+    const std::byte* const end = input + size;
+    std::byte* out = output;
+    std::byte* const out_end = output + capacity;
+    while (in < end)
+    {
+        const unsigned int token = static_cast<unsigned int>(*in++);
+        const size_t literal_length = read_length(in, end, token >> 4);
+        if (literal_length > static_cast<size_t>(end - in) || literal_length > static_cast<size_t>(out_end - out))
+        {
+            throw std::runtime_error("decompress_block: invalid literals.");
+        }
+        std::memcpy(out, in, literal_length);
+        in += literal_length;
+        out += literal_length;
+        if (in == end)
+        {
+            break;
+        }
+
+        if (end - in < 2)
+        {
+            throw std::runtime_error("decompress_block: truncated block.");
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        const size_t match_length = read_length(in, end, token & 15) + MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(out - output)
+            || match_length > static_cast<size_t>(out_end - out))
+        {
+            throw std::runtime_error("decompress_block: invalid match.");
+        }
+        const std::byte* match = out - offset;
+        if (offset >= match_length)
+        {
+            std::memcpy(out, match, match_length);
+            out += match_length;
+        }
+        else
+        {
+            // The match overlaps the output, so it repeats a pattern.
+            for (size_t i = 0; i < match_length; i++)
+            {
+                *out++ = match[i];
+            }
+        }
+    }
+    return out - output;
+}
+
+#endif // ALS_UTILITIES_COMPRESSION_CPP
@@ -0,0 +1,365 @@
+/** 
+ * @file Compression.hpp
+ * @brief This file contains a fast LZ block compressor and streams that
+ * compress everything written through them.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A @a CompressedSink splits the data written to it into blocks of at most
+ * @a COMPRESSION_BLOCK_SIZE bytes, compresses each of them with
+ * @a compress_block and forwards them to another sink. A @a CompressedSource
+ * reads them back. Both can be used with @a write_to_file and @a read_from_file
+ * like any other stream, and they can be combined with archives:
+ * 
+ * FdSink file("data.bin");
+ * CompressedSink compressed(file);
+ * ArchiveSink archive(compressed);
+ * write_to_file(object, archive);
+ * 
+ * The compressed data starts with COMPRESSION_MAGIC and the block size (32 bits),
+ * followed by the blocks. Each block starts with its uncompressed size and its
+ * stored size (32 bits each); if both are equal, the block is stored without
+ * compression. An empty block marks the end of the data. Blocks do not refer to
+ * each other, so they can be decompressed independently.
+ * 
+ * The block format is the LZ4 block format: sequences of literals followed by
+ * a match with a 16-bit offset and a length of at least 4 bytes.
+ */
+
+#ifndef ALS_UTILITIES_COMPRESSION_HPP
+#define ALS_UTILITIES_COMPRESSION_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Default size in bytes of the blocks of a @a CompressedSink .
+     */
+    inline constexpr size_t COMPRESSION_BLOCK_SIZE = 1 << 18;
+
+    /**
+     * @brief Largest block size accepted by a @a CompressedSource .
+     */
+    inline constexpr size_t COMPRESSION_MAX_BLOCK_SIZE = 1 << 26;
+
+    /**
+     * @brief Magic number at the beginning of compressed data.
+     */
+    inline constexpr unsigned char COMPRESSION_MAGIC[4] = {'A', 'L', 'S', 'Z'};
+
+    /**
+     * @brief Returns the largest size of the compression of size bytes.
+     * 
+     * @param size
+     * @return size_t
+     */
+    size_t inline compress_bound(const size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    /**
+     * @brief Compresses a block of data.
+     * 
+     * @param input
+     * @param size size of the input in bytes.
+     * @param output buffer of at least compress_bound(size) bytes.
+     * @return size_t size of the compressed data in bytes.
+     */
+    size_t compress_block(const std::byte* input, const size_t size, std::byte* output);
+
+    /**
+     * @brief Decompresses a block of data. Throws std::runtime_error if the data
+     * is not valid or does not fit in the output.
+     * 
+     * @param input
+     * @param size size of the input in bytes.
+     * @param output
+     * @param capacity size of the output in bytes.
+     * @return size_t size of the decompressed data in bytes.
+     */
+    size_t decompress_block(const std::byte* input, const size_t size, std::byte* output, const size_t capacity);
+
+    /**
+     * @brief Sink that compresses everything written to it and forwards it to
+     * another sink.
+     * 
+     * The data is compressed one block at a time, so nothing reaches the
+     * underlying sink until a block is full, @a flush is called or the sink is
+     * closed. The end of the data is written by @a close or by the destructor.
+     * 
+     * @tparam Sink a FILE pointer or a sink.
+     */
+    template <class Sink>
+    class CompressedSink
+    {
+    public:
+        /**
+         * @brief Construct a new Compressed Sink object and write the magic number.
+         * 
+         * @param sink
+         * @param block_size size in bytes of the uncompressed blocks.
+         */
+        explicit CompressedSink(stream_reference_t<Sink> sink, const size_t block_size = COMPRESSION_BLOCK_SIZE)
+            : sink_(sink), block_size_(block_size), position_(0), used_(0), closed_(false)
+        {
+            if (block_size_ == 0 || block_size_ > COMPRESSION_MAX_BLOCK_SIZE)
+            {
+                throw std::invalid_argument("CompressedSink: invalid block size.");
+            }
+            block_.reset(new std::byte[block_size_]);
+            compressed_.reset(new std::byte[compress_bound(block_size_)]);
+            const std::uint32_t size = block_size_;
+            write_bytes(sink_, COMPRESSION_MAGIC, sizeof(COMPRESSION_MAGIC));
+            write_bytes(sink_, &size, sizeof(size));
+        }
+
+        CompressedSink(const CompressedSink&) = delete;
+        CompressedSink& operator=(const CompressedSink&) = delete;
+
+        /**
+         * @brief Closes the sink if it has not been closed yet. Errors can only
+         * be detected by calling @a close beforehand.
+         * 
+         */
+        ~CompressedSink()
+        {
+            if (!closed_)
+            {
+                try
+                {
+                    close();
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+
+        void write(const void* data, size_t bytes)
+        {
+            const std::byte* source = static_cast<const std::byte*>(data);
+            while (bytes > 0)
+            {
+                const size_t n = std::min(bytes, block_size_ - used_);
+                std::memcpy(block_.get() + used_, source, n);
+                used_ += n;
+                source += n;
+                bytes -= n;
+                if (used_ == block_size_)
+                {
+                    write_block();
+                }
+            }
+        }
+
+        /**
+         * @brief Compresses whatever has been written so far and flushes the
+         * underlying sink.
+         * 
+         */
+        void flush()
+        {
+            write_block();
+            flush_stream(sink_);
+        }
+
+        size_t tell() const { return position_ + used_; }
+
+        /**
+         * @brief Overwrites data that has not been compressed yet. Throws
+         * std::out_of_range if the data has already been compressed.
+         * 
+         * @param offset
+         * @param data
+         * @param bytes
+         */
+        void patch(const size_t offset, const void* data, const size_t bytes)
+        {
+            if (offset < position_ || offset + bytes > position_ + used_)
+            {
+                throw std::out_of_range("CompressedSink: the data has already been compressed.");
+            }
+            std::memcpy(block_.get() + (offset - position_), data, bytes);
+        }
+
+        /**
+         * @brief Compresses whatever has been written so far and writes the end
+         * of the data. Nothing can be written afterwards.
+         * 
+         */
+        void close()
+        {
+            write_block();
+            const std::uint32_t end[2] = {0, 0};
+            write_bytes(sink_, end, sizeof(end));
+            flush_stream(sink_);
+            closed_ = true;
+        }
+
+    private:
+        void write_block()
+        {
+            if (used_ == 0)
+            {
+                return;
+            }
+            const size_t size = compress_block(block_.get(), used_, compressed_.get());
+            const bool stored = (size >= used_);
+            const std::uint32_t header[2] = {static_cast<std::uint32_t>(used_),
+                static_cast<std::uint32_t>(stored ? used_ : size)};
+            write_bytes(sink_, header, sizeof(header));
+            write_bytes(sink_, stored ? block_.get() : compressed_.get(), header[1]);
+            position_ += used_;
+            used_ = 0;
+        }
+
+        stream_reference_t<Sink> sink_;
+        size_t block_size_;
+        std::unique_ptr<std::byte[]> block_;
+        std::unique_ptr<std::byte[]> compressed_;
+        size_t position_;
+        size_t used_;
+        bool closed_;
+    };
+
+    template <class Sink>
+    CompressedSink(Sink&) -> CompressedSink<Sink>;
+
+    template <class Sink>
+    CompressedSink(Sink&, size_t) -> CompressedSink<Sink>;
+
+    CompressedSink(FILE*) -> CompressedSink<FILE*>;
+
+    CompressedSink(FILE*, size_t) -> CompressedSink<FILE*>;
+
+    /**
+     * @brief Source that decompresses the data written by a @a CompressedSink .
+     * Throws std::runtime_error if the data is not valid or ends prematurely.
+     * 
+     * @tparam Source a FILE pointer or a source.
+     */
+    template <class Source>
+    class CompressedSource
+    {
+    public:
+        /**
+         * @brief Construct a new Compressed Source object and read the magic number.
+         * 
+         * @param source
+         */
+        explicit CompressedSource(stream_reference_t<Source> source)
+            : source_(source), position_(0), begin_(0), end_(0), finished_(false)
+        {
+            unsigned char magic[sizeof(COMPRESSION_MAGIC)];
+            std::uint32_t size;
+            read_bytes(source_, magic, sizeof(magic));
+            read_bytes(source_, &size, sizeof(size));
+            if (std::memcmp(magic, COMPRESSION_MAGIC, sizeof(magic)) != 0)
+            {
+                throw std::runtime_error("CompressedSource: the data is not compressed.");
+            }
+            if (size == 0 || size > COMPRESSION_MAX_BLOCK_SIZE)
+            {
+                throw std::runtime_error("CompressedSource: invalid block size.");
+            }
+            block_size_ = size;
+            block_.reset(new std::byte[block_size_]);
+            compressed_.reset(new std::byte[block_size_]);
+        }
+
+        void read(void* data, size_t bytes)
+        {
+            std::byte* destination = static_cast<std::byte*>(data);
+            while (bytes > 0)
+            {
+                if (begin_ == end_)
+                {
+                    read_block();
+                }
+                const size_t n = std::min(bytes, end_ - begin_);
+                std::memcpy(destination, block_.get() + begin_, n);
+                begin_ += n;
+                destination += n;
+                bytes -= n;
+            }
+        }
+
+        void skip(size_t bytes)
+        {
+            while (bytes > 0)
+            {
+                if (begin_ == end_)
+                {
+                    read_block();
+                }
+                const size_t n = std::min(bytes, end_ - begin_);
+                begin_ += n;
+                bytes -= n;
+            }
+        }
+
+        size_t tell() const { return position_ - (end_ - begin_); }
+
+    private:
+        void read_block()
+        {
+            std::uint32_t header[2] = {0, 0};
+            if (!finished_)
+            {
+                read_bytes(source_, header, sizeof(header));
+            }
+            if (header[0] == 0)
+            {
+                finished_ = true;
+                throw EndOfData("CompressedSource: unexpected end of data.");
+            }
+            if (header[0] > block_size_ || header[1] > header[0])
+            {
+                throw std::runtime_error("CompressedSource: invalid block.");
+            }
+            if (header[1] == header[0])
+            {
+                read_bytes(source_, block_.get(), header[0]);
+            }
+            else
+            {
+                read_bytes(source_, compressed_.get(), header[1]);
+                if (decompress_block(compressed_.get(), header[1], block_.get(), block_size_) != header[0])
+                {
+                    throw std::runtime_error("CompressedSource: invalid block.");
+                }
+            }
+            position_ += header[0];
+            begin_ = 0;
+            end_ = header[0];
+        }
+
+        stream_reference_t<Source> source_;
+        size_t block_size_;
+        std::unique_ptr<std::byte[]> block_;
+        std::unique_ptr<std::byte[]> compressed_;
+        size_t position_;
+        size_t begin_;
+        size_t end_;
+        bool finished_;
+    };
+
+    template <class Source>
+    CompressedSource(Source&) -> CompressedSource<Source>;
+
+    CompressedSource(FILE*) -> CompressedSource<FILE*>;
+}
+
+#endif // ALS_UTILITIES_COMPRESSION_HPP
@@ -0,0 +1,308 @@
+#ifndef ALS_UTILITIES_DIRECT_IO_CPP
+#define ALS_UTILITIES_DIRECT_IO_CPP
+
+#include "DirectIO.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+namespace
+{
+#ifdef O_DIRECT
+    constexpr int DIRECT_FLAG = O_DIRECT;
+#else
+    constexpr int DIRECT_FLAG = 0;
+#endif
+
+    size_t align_up(const size_t bytes)
+    {
+        return (bytes + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    }
+
+    size_t align_down(const size_t bytes)
+    {
+        return bytes / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    }
+
+    int open_direct(const std::string& path, bool& direct)
+    {
+        const int flags = O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC;
+        int fd = (DIRECT_FLAG != 0) ? open(path.c_str(), flags | DIRECT_FLAG, 0644) : -1;
+        direct = (fd >= 0);
+        if (fd < 0 && (DIRECT_FLAG == 0 || errno == EINVAL))
+        {
+            // The file system does not support direct I/O.
+            fd = open(path.c_str(), flags, 0644);
+        }
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "DirectSink: cannot open " + path);
+        }
+        return fd;
+    }
+
+    void read_at(const int fd, std::byte* data, size_t bytes, size_t offset)
+    {
+        while (bytes > 0)
+        {
+            const ssize_t n = pread(fd, data, bytes, offset);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "DirectSink: read failed");
+            }
+            if (n == 0)
+            {
+                // Beyond the end of the file.
+                std::memset(data, 0, bytes);
+                return;
+            }
+            data += n;
+            bytes -= n;
+            offset += n;
+        }
+    }
+}
+
+DirectSink::AlignedBuffer DirectSink::allocate(const size_t bytes)
+{
+    void* data = std::aligned_alloc(DIRECT_IO_ALIGNMENT, bytes);
+    if (data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return AlignedBuffer(static_cast<std::byte*>(data));
+}
+
+DirectSink::DirectSink(const std::string& path, const size_t buffer_size)
+    : fd_(-1), direct_(false), capacity_(align_up(std::max<size_t>(buffer_size, 1))),
+    current_(0), position_(0), used_(0), closed_(false),
+    job_data_(nullptr), job_bytes_(0), job_offset_(0), busy_(false), stopping_(false)
+{
+    buffers_[0] = allocate(capacity_);
+    buffers_[1] = allocate(capacity_);
+    bool direct;
+    fd_ = open_direct(path, direct);
+    direct_ = direct;
+    thread_ = std::thread(&DirectSink::run, this);
+}
+
+DirectSink::~DirectSink()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+void DirectSink::write(const void* data, size_t bytes)
+{
+    const std::byte* source = static_cast<const std::byte*>(data);
+    while (bytes > 0)
+    {
+        const size_t n = std::min(bytes, capacity_ - used_);
+        std::memcpy(buffers_[current_].get() + used_, source, n);
+        used_ += n;
+        source += n;
+        bytes -= n;
+        if (used_ == capacity_)
+        {
+            submit(capacity_);
+            position_ += capacity_;
+            used_ = 0;
+        }
+    }
+}
+
+void DirectSink::flush()
+{
+    if (used_ > 0)
+    {
+        // The last block is padded with zeros and written whole. Its data stays in
+        // the buffer, so that it is written again once more data follows.
+        const size_t padded = align_up(used_);
+        std::memset(buffers_[current_].get() + used_, 0, padded - used_);
+        const std::byte* written = buffers_[current_].get();
+        submit(padded);
+        const size_t kept = used_ - align_down(used_);
+        std::memcpy(buffers_[current_].get(), written + align_down(used_), kept);
+        position_ += align_down(used_);
+        used_ = kept;
+    }
+    wait();
+}
+
+void DirectSink::patch(const size_t offset, const void* data, const size_t bytes)
+{
+    const std::byte* source = static_cast<const std::byte*>(data);
+    const size_t end = offset + bytes;
+    if (end > position_ + used_)
+    {
+        throw std::out_of_range("DirectSink: the data has not been written yet.");
+    }
+    if (offset < position_)
+    {
+        // The blocks are read back, modified and rewritten. Since position_ is
+        // aligned, they have all left the buffers.
+        wait();
+        const size_t first = align_down(offset);
+        const size_t last = align_up(std::min(end, position_));
+        AlignedBuffer blocks = allocate(last - first);
+        read_at(fd_, blocks.get(), last - first, first);
+        const size_t n = std::min(end, position_) - offset;
+        std::memcpy(blocks.get() + (offset - first), source, n);
+        write_at(blocks.get(), last - first, first);
+    }
+    if (end > position_)
+    {
+        const size_t start = std::max(offset, position_);
+        std::memcpy(buffers_[current_].get() + (start - position_), source + (start - offset), end - start);
+    }
+}
+
+void DirectSink::close()
+{
+    if (closed_)
+    {
+        return;
+    }
+    closed_ = true;
+    std::exception_ptr error;
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_one();
+    thread_.join();
+
+    // The padding of the last block is cut off.
+    if (!error && ftruncate(fd_, tell()) != 0)
+    {
+        error = std::make_exception_ptr(std::system_error(errno, std::generic_category(), "DirectSink: truncate failed"));
+    }
+    if (::close(fd_) != 0 && !error)
+    {
+        error = std::make_exception_ptr(std::system_error(errno, std::generic_category(), "DirectSink: close failed"));
+    }
+    fd_ = -1;
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void DirectSink::submit(const size_t bytes)
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_data_ = buffers_[current_].get();
+        job_bytes_ = bytes;
+        job_offset_ = position_;
+        busy_ = true;
+    }
+    ready_.notify_one();
+    current_ ^= 1;
+}
+
+void DirectSink::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return !busy_; });
+    if (error_)
+    {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+void DirectSink::run()
+{
+    while (true)
+    {
+        const std::byte* data;
+        size_t bytes;
+        size_t offset;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return busy_ || stopping_; });
+            if (!busy_)
+            {
+                return;
+            }
+            data = job_data_;
+            bytes = job_bytes_;
+            offset = job_offset_;
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            write_at(data, bytes, offset);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = error;
+            busy_ = false;
+        }
+        done_.notify_one();
+    }
+}
+
+void DirectSink::write_at(const std::byte* data, size_t bytes, size_t offset)
+{
+    while (bytes > 0)
+    {
+        const ssize_t written = pwrite(fd_, data, bytes, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EINVAL && direct_)
+            {
+                // Some file systems accept O_DIRECT when opening but not when writing.
+                const int flags = fcntl(fd_, F_GETFL);
+                if (flags >= 0 && fcntl(fd_, F_SETFL, flags & ~DIRECT_FLAG) == 0)
+                {
+                    direct_ = false;
+                    continue;
+                }
+            }
+            throw std::system_error(errno, std::generic_category(), "DirectSink: write failed");
+        }
+        data += written;
+        bytes -= written;
+        offset += written;
+    }
+}
+
+#endif // ALS_UTILITIES_DIRECT_IO_CPP
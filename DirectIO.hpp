@@ -0,0 +1,169 @@
+/** 
+ * @file DirectIO.hpp
+ * @brief This file contains a sink that writes files with direct I/O, bypassing
+ * the page cache.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * Writing a large file through the page cache evicts the data other programs
+ * are using. A @a DirectSink opens the file with O_DIRECT instead, so the data
+ * goes from its buffers to the disk without being cached:
+ * 
+ * DirectSink file("checkpoint.bin");
+ * ArchiveSink archive(file);
+ * write_to_file(state, archive);
+ * file.close();
+ * 
+ * Direct I/O requires aligned buffers, offsets and sizes. The sink gathers the
+ * data in two aligned buffers of the same size: while one of them is being
+ * written by a background thread, the other one is filled. The last, unaligned
+ * block is padded with zeros and the file is truncated to its actual size.
+ * 
+ * File systems that do not support O_DIRECT (e.g. some FUSE file systems) get
+ * the same writes through the page cache; @a DirectSink::direct tells which is
+ * the case.
+ */
+
+#ifndef ALS_UTILITIES_DIRECT_IO_HPP
+#define ALS_UTILITIES_DIRECT_IO_HPP
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Alignment in bytes of the buffers, offsets and sizes of direct I/O.
+     * It is a multiple of the logical block size of usual devices.
+     */
+    inline constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    /**
+     * @brief Default size in bytes of each of the two buffers of a @a DirectSink .
+     */
+    inline constexpr size_t DEFAULT_DIRECT_BUFFER_SIZE = 8 << 20;
+
+    /**
+     * @brief Sink that creates (or truncates) a file and writes it with direct I/O,
+     * through two buffers so that filling one overlaps with writing the other.
+     * 
+     * The file gets its final size when the sink is closed, either by @a close
+     * or by the destructor. Errors can only be detected by calling @a close
+     * beforehand.
+     */
+    class DirectSink
+    {
+    public:
+        /**
+         * @brief Construct a new Direct Sink object and start its thread.
+         * Throws std::system_error if the file cannot be created.
+         * 
+         * @param path
+         * @param buffer_size size in bytes of each buffer, rounded up to a
+         * multiple of DIRECT_IO_ALIGNMENT.
+         */
+        explicit DirectSink(const std::string& path, const size_t buffer_size = DEFAULT_DIRECT_BUFFER_SIZE);
+
+        DirectSink(const DirectSink&) = delete;
+        DirectSink& operator=(const DirectSink&) = delete;
+
+        /**
+         * @brief Closes the sink if it has not been closed yet.
+         * 
+         */
+        ~DirectSink();
+
+        void write(const void* data, size_t bytes);
+
+        /**
+         * @brief Writes whatever has been written so far, padding the last block,
+         * and waits until it is on its way to the disk.
+         * 
+         */
+        void flush();
+
+        size_t tell() const { return position_ + used_; }
+
+        /**
+         * @brief Overwrites data that has already been written. Data that has
+         * left the buffers is rewritten whole blocks at a time.
+         * 
+         * @param offset
+         * @param data
+         * @param bytes
+         */
+        void patch(const size_t offset, const void* data, const size_t bytes);
+
+        /**
+         * @brief Writes the remaining data, truncates the file to its actual size
+         * and closes it. Nothing can be written afterwards.
+         * 
+         */
+        void close();
+
+        /**
+         * @brief Checks whether the file is written with direct I/O. Otherwise,
+         * the file system rejected it and the file is written through the page cache.
+         * 
+         * @return true
+         * @return false
+         */
+        bool direct() const { return direct_; }
+
+        /**
+         * @brief Returns the underlying file descriptor.
+         * 
+         * @return int
+         */
+        int fd() const { return fd_; }
+
+    private:
+        struct AlignedFree
+        {
+            void operator()(std::byte* data) const { std::free(data); }
+        };
+
+        using AlignedBuffer = std::unique_ptr<std::byte, AlignedFree>;
+
+        static AlignedBuffer allocate(const size_t bytes);
+
+        void submit(const size_t bytes);
+        void wait();
+        void run();
+        void write_at(const std::byte* data, const size_t bytes, const size_t offset);
+
+        int fd_;
+        std::atomic<bool> direct_;
+        size_t capacity_;
+        AlignedBuffer buffers_[2];
+        int current_;
+        size_t position_;
+        size_t used_;
+        bool closed_;
+
+        // Write handed over to the thread.
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::condition_variable done_;
+        const std::byte* job_data_;
+        size_t job_bytes_;
+        size_t job_offset_;
+        bool busy_;
+        bool stopping_;
+        std::exception_ptr error_;
+        std::thread thread_;
+    };
+}
+
+#endif // ALS_UTILITIES_DIRECT_IO_HPP
@@ -0,0 +1,615 @@
+/** 
+ * @file Encodings.hpp
+ * @brief This file contains compact encodings for arrays of numbers.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * Vectors and deques of numbers written to archives (see Archive.hpp) carry a
+ * tag with the @a Encoding of their elements, so @a read_from_file always
+ * knows how to decode them. Currently, we offer:
+ * - @a Encoding::RAW : the bytes of the elements, as in files without header.
+ * - @a Encoding::VARINT : integers as LEB128 variable-length integers. Signed
+ * integers are zigzag-encoded first, so that small negative values are short.
+ * - @a Encoding::DELTA_VARINT : differences between consecutive integers as
+ * zigzag-encoded LEB128 integers. It is ideal for increasing sequences such as
+ * indices.
+ * - @a Encoding::XOR : floating-point numbers XORed with the previous one, with
+ * their leading and trailing zero bits elided, as in Facebook's Gorilla. It is
+ * ideal for smooth time series, where neighbouring values share their sign,
+ * exponent and first bits of the mantissa.
+ * 
+ * Encoded elements are stored as the number of bytes of the encoding
+ * (64 bits) followed by the encoding itself.
+ */
+
+#ifndef ALS_UTILITIES_ENCODINGS_HPP
+#define ALS_UTILITIES_ENCODINGS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <bit>
+#include <stdexcept>
+#include <type_traits>
+
+namespace als::utilities
+{
+    /**
+     * @brief Encoding of the elements of a container of numbers.
+     * 
+     */
+    enum class Encoding : unsigned char
+    {
+        RAW = 0,
+        VARINT = 1,
+        DELTA_VARINT = 2,
+        XOR = 3
+    };
+
+    /**
+     * @brief Checks whether containers of T carry an encoding tag in archives.
+     * This is the case for integers (except bool), float and double.
+     * 
+     * @tparam T
+     */
+    template <class T>
+    inline constexpr bool has_encoding_tag_v = (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+    /**
+     * @brief Checks whether an encoding can be used with elements of type T.
+     * 
+     * @tparam T
+     * @param encoding
+     * @return true
+     * @return false
+     */
+    template <class T>
+    bool inline is_valid_encoding(const Encoding encoding)
+    {
+        switch (encoding)
+        {
+            case Encoding::RAW:
+                return true;
+            case Encoding::VARINT:
+            case Encoding::DELTA_VARINT:
+                return std::is_integral_v<T>;
+            case Encoding::XOR:
+                return std::is_floating_point_v<T>;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Maximum number of bytes of a LEB128 encoded 64-bit integer.
+     */
+    inline constexpr size_t MAX_VARINT_SIZE = 10;
+
+    /**
+     * @brief Maps an integer to the unsigned value that is stored as a LEB128 integer.
+     * 
+     * @tparam T an integral type.
+     * @param x
+     * @param previous the previous element, for delta encoding.
+     * @param delta whether delta encoding is used.
+     * @return std::uint64_t
+     */
+    template <class T>
+    std::uint64_t inline to_varint_value(const T x, const T previous, const bool delta)
+    {
+        using U = std::make_unsigned_t<T>;
+        constexpr int bits = 8 * sizeof(T);
+        const U u = delta ? static_cast<U>(static_cast<U>(x) - static_cast<U>(previous)) : static_cast<U>(x);
+        if (delta || std::is_signed_v<T>)
+        {
+            // Zigzag encoding: 0, -1, 1, -2, 2... are mapped to 0, 1, 2, 3, 4...
+            return static_cast<U>(static_cast<U>(u << 1) ^ static_cast<U>(-static_cast<U>(u >> (bits - 1))));
+        }
+        return u;
+    }
+
+    /**
+     * @brief Inverse of @a to_varint_value .
+     * 
+     * @tparam T an integral type.
+     * @param v
+     * @param previous the previous element, for delta encoding.
+     * @param delta whether delta encoding is used.
+     * @return T
+     */
+    template <class T>
+    T inline from_varint_value(const std::uint64_t v, const T previous, const bool delta)
+    {
+        using U = std::make_unsigned_t<T>;
+        U u = static_cast<U>(v);
+        if (delta || std::is_signed_v<T>)
+        {
+            u = static_cast<U>(static_cast<U>(u >> 1) ^ static_cast<U>(-static_cast<U>(u & 1)));
+        }
+        return delta ? static_cast<T>(static_cast<U>(static_cast<U>(previous) + u)) : static_cast<T>(u);
+    }
+
+    /**
+     * @brief Returns the number of bytes of the LEB128 encoding of v.
+     * 
+     * @param v
+     * @return size_t
+     */
+    size_t inline varint_size(std::uint64_t v)
+    {
+        size_t size = 1;
+        while (v >= 0x80)
+        {
+            v >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    /**
+     * @brief Returns the number of bytes needed to encode N integers.
+     * 
+     * @tparam T an integral type.
+     * @param data
+     * @param N
+     * @param delta whether delta encoding is used.
+     * @param previous the element before data[0], for delta encoding. It is
+     * updated with the last element.
+     * @return size_t
+     */
+    template <class T>
+    size_t inline varint_encoded_size(const T* data, const size_t N, const bool delta, T& previous)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            size += varint_size(to_varint_value(data[i], previous, delta));
+            previous = data[i];
+        }
+        return size;
+    }
+
+    /**
+     * @brief Encodes N integers as LEB128 integers.
+     * 
+     * @tparam T an integral type.
+     * @param data
+     * @param N
+     * @param delta whether delta encoding is used.
+     * @param previous the element before data[0], for delta encoding. It is
+     * updated with the last element.
+     * @param out buffer of at least N * MAX_VARINT_SIZE bytes.
+     * @return std::byte* the end of the encoding.
+     */
+    template <class T>
+    inline std::byte* encode_varints(const T* data, const size_t N, const bool delta, T& previous, std::byte* out)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            std::uint64_t v = to_varint_value(data[i], previous, delta);
+            previous = data[i];
+            while (v >= 0x80)
+            {
+                *out++ = std::byte((v & 0x7f) | 0x80);
+                v >>= 7;
+            }
+            *out++ = std::byte(v);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Decodes up to N LEB128 integers from [in, end). It stops before the
+     * first integer that is not complete. Throws std::runtime_error if an integer
+     * is longer than MAX_VARINT_SIZE bytes.
+     * 
+     * Runs of eight one-byte integers, which are very common with delta encoding,
+     * are detected with a single 64-bit test and decoded together.
+     * 
+     * @tparam T an integral type.
+     * @param in beginning of the data. It is moved past the decoded integers.
+     * @param end end of the data.
+     * @param out
+     * @param N
+     * @param delta whether delta encoding is used.
+     * @param previous the element before out[0], for delta encoding. It is
+     * updated with the last decoded element.
+     * @return size_t number of decoded integers.
+     */
+    template <class T>
+    size_t inline decode_varints(const std::byte*& in, const std::byte* end, T* out, const size_t N,
+        const bool delta, T& previous)
+    {
+        size_t i = 0;
+        while (i < N)
+        {
+            if (N - i >= 8 && end - in >= 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, in, 8);
+                if ((word & 0x8080808080808080ULL) == 0)
+                {
+                    for (size_t k = 0; k < 8; k++)
+                    {
+                        previous = out[i + k] = from_varint_value<T>(static_cast<std::uint64_t>(in[k]), previous, delta);
+                    }
+                    in += 8;
+                    i += 8;
+                    continue;
+                }
+            }
+
+            std::uint64_t v = 0;
+            const std::byte* p = in;
+            for (int shift = 0; ; shift += 7)
+            {
+                if (p == end)
+                {
+                    return i;
+                }
+                if (shift >= 7 * (int)MAX_VARINT_SIZE)
+                {
+                    throw std::runtime_error("decode_varints: malformed integer.");
+                }
+                const std::uint64_t byte = static_cast<std::uint64_t>(*p++);
+                v |= (byte & 0x7f) << shift;
+                if (byte < 0x80)
+                {
+                    break;
+                }
+            }
+            in = p;
+            previous = out[i++] = from_varint_value<T>(v, previous, delta);
+        }
+        return i;
+    }
+    /**
+     * @brief Encoder of integers as LEB128 integers, one chunk at a time.
+     * 
+     * @tparam T an integral type.
+     */
+    template <class T>
+    class VarintEncoder
+    {
+    public:
+        /**
+         * @brief Maximum number of bytes of the encoding of one element.
+         */
+        static constexpr size_t MAX_CODE_SIZE = MAX_VARINT_SIZE;
+
+        explicit VarintEncoder(const bool delta) : delta_(delta), previous_(0), bytes_(0) {}
+
+        /**
+         * @brief Adds the size of the encoding of N more elements to @a measured_bytes ,
+         * without encoding them.
+         * 
+         * @param data 
+         * @param N 
+         */
+        void measure(const T* data, const size_t N) { bytes_ += varint_encoded_size(data, N, delta_, previous_); }
+
+        std::uint64_t measured_bytes() const { return bytes_; }
+
+        /**
+         * @brief Encodes N more elements.
+         * 
+         * @param data 
+         * @param N 
+         * @param out buffer of at least N * MAX_CODE_SIZE + 8 bytes.
+         * @return std::byte* the end of the encoding.
+         */
+        std::byte* encode(const T* data, const size_t N, std::byte* out)
+        {
+            return encode_varints(data, N, delta_, previous_, out);
+        }
+
+        /**
+         * @brief Writes whatever is left after the last element.
+         * 
+         * @param out buffer of at least 8 bytes.
+         * @return std::byte* the end of the encoding.
+         */
+        std::byte* finish(std::byte* out) { return out; }
+
+    private:
+        bool delta_;
+        T previous_;
+        std::uint64_t bytes_;
+    };
+
+    /**
+     * @brief Decoder of the integers written by a @a VarintEncoder .
+     * 
+     * @tparam T an integral type.
+     */
+    template <class T>
+    class VarintDecoder
+    {
+    public:
+        static constexpr size_t MAX_CODE_SIZE = MAX_VARINT_SIZE;
+
+        explicit VarintDecoder(const bool delta) : delta_(delta), previous_(0) {}
+
+        /**
+         * @brief Decodes up to N elements from [in, end). See @a decode_varints .
+         * 
+         * @param in beginning of the data. It is moved past the decoded elements.
+         * @param end end of the data.
+         * @param out 
+         * @param N 
+         * @return size_t number of decoded elements.
+         */
+        size_t decode(const std::byte*& in, const std::byte* end, T* out, const size_t N)
+        {
+            return decode_varints(in, end, out, N, delta_, previous_);
+        }
+
+        /**
+         * @brief Checks that nothing but padding is left after the last element.
+         * 
+         * @return true 
+         * @return false 
+         */
+        bool finished() const { return true; }
+
+    private:
+        bool delta_;
+        T previous_;
+    };
+
+    /**
+     * @brief Encoder of floating-point numbers as XORs with the previous number,
+     * one chunk at a time.
+     * 
+     * Each number x is stored as the bits of y = x ^ previous, most significant
+     * bit first:
+     * - '0' if y is zero.
+     * - '10' and the bits of y between the leading and trailing zeros of the
+     * previous stored y, if y has at least as many leading and trailing zeros.
+     * - '11', 5 bits with the number of leading zeros of y, 5 (float) or 6 (double)
+     * bits with the number of meaningful bits minus one and the meaningful bits.
+     * 
+     * The first number is XORed with 0. The last byte is padded with zeros.
+     * 
+     * @tparam T float or double.
+     */
+    template <class T>
+    class XorEncoder
+    {
+    public:
+        using bits_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+        static constexpr int BITS = 8 * sizeof(T);
+        static constexpr int LEADING_BITS = 5;
+        static constexpr int LENGTH_BITS = (sizeof(T) == 4) ? 5 : 6;
+        static constexpr size_t MAX_CODE_SIZE = (2 + LEADING_BITS + LENGTH_BITS + BITS + 7) / 8;
+
+        static_assert(std::is_floating_point_v<T> && sizeof(T) == sizeof(bits_type),
+            "XorEncoder: only float and double can be encoded.");
+
+        XorEncoder() : previous_(0), leading_(-1), trailing_(0), buffer_(0), filled_(0), bits_(0) {}
+
+        void measure(const T* data, const size_t N)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                code(std::bit_cast<bits_type>(data[i]), [&](std::uint64_t, const int n) { bits_ += n; });
+            }
+        }
+
+        std::uint64_t measured_bytes() const { return (bits_ + 7) / 8; }
+
+        std::byte* encode(const T* data, const size_t N, std::byte* out)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                code(std::bit_cast<bits_type>(data[i]), [&](const std::uint64_t v, const int n) { put(v, n, out); });
+            }
+            return out;
+        }
+
+        std::byte* finish(std::byte* out)
+        {
+            if (filled_ > 0)
+            {
+                *out++ = std::byte(buffer_ >> 56);
+                buffer_ = 0;
+                filled_ = 0;
+            }
+            return out;
+        }
+
+    private:
+        template <class Emit>
+        void code(const bits_type x, Emit&& emit)
+        {
+            const bits_type y = x ^ previous_;
+            previous_ = x;
+            if (y == 0)
+            {
+                emit(0, 1);
+                return;
+            }
+            const int leading = std::min(std::countl_zero(y), (1 << LEADING_BITS) - 1);
+            const int trailing = std::countr_zero(y);
+            if (leading_ >= 0 && leading >= leading_ && trailing >= trailing_)
+            {
+                emit(0b10, 2);
+                emit(y >> trailing_, BITS - leading_ - trailing_);
+            }
+            else
+            {
+                const int length = BITS - leading - trailing;
+                emit(0b11, 2);
+                emit(leading, LEADING_BITS);
+                emit(length - 1, LENGTH_BITS);
+                emit(y >> trailing, length);
+                leading_ = leading;
+                trailing_ = trailing;
+            }
+        }
+
+        void put(const std::uint64_t v, const int n, std::byte*& out)
+        {
+            if (filled_ + n > 64)
+            {
+                put(v >> 32, n - 32, out);
+                put(v & 0xffffffff, 32, out);
+                return;
+            }
+            if (n > 0)
+            {
+                buffer_ |= v << (64 - filled_ - n);
+                filled_ += n;
+            }
+            while (filled_ >= 8)
+            {
+                *out++ = std::byte(buffer_ >> 56);
+                buffer_ <<= 8;
+                filled_ -= 8;
+            }
+        }
+
+        bits_type previous_;
+        int leading_;
+        int trailing_;
+        std::uint64_t buffer_;
+        int filled_;
+        std::uint64_t bits_;
+    };
+
+    /**
+     * @brief Decoder of the numbers written by a @a XorEncoder .
+     * 
+     * @tparam T float or double.
+     */
+    template <class T>
+    class XorDecoder
+    {
+    public:
+        using bits_type = typename XorEncoder<T>::bits_type;
+        static constexpr int BITS = XorEncoder<T>::BITS;
+        static constexpr int LEADING_BITS = XorEncoder<T>::LEADING_BITS;
+        static constexpr int LENGTH_BITS = XorEncoder<T>::LENGTH_BITS;
+        static constexpr size_t MAX_CODE_SIZE = XorEncoder<T>::MAX_CODE_SIZE;
+
+        XorDecoder() : previous_(0), leading_(-1), trailing_(0), buffer_(0), available_(0) {}
+
+        /**
+         * @brief Decodes up to N numbers from [in, end). It stops before the first
+         * number that is not complete. Throws std::runtime_error if the data is
+         * not valid.
+         * 
+         * @param in beginning of the data. It is moved past the consumed bytes.
+         * @param end end of the data.
+         * @param out 
+         * @param N 
+         * @return size_t number of decoded numbers.
+         */
+        size_t decode(const std::byte*& in, const std::byte* end, T* out, const size_t N)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                const std::byte* const saved_in = in;
+                const std::uint64_t saved_buffer = buffer_;
+                const int saved_available = available_;
+                if (!decode(in, end, out[i]))
+                {
+                    in = saved_in;
+                    buffer_ = saved_buffer;
+                    available_ = saved_available;
+                    return i;
+                }
+            }
+            return N;
+        }
+
+        bool finished() const { return available_ < 8 && buffer_ == 0; }
+
+    private:
+        bool decode(const std::byte*& in, const std::byte* end, T& out)
+        {
+            std::uint64_t control;
+            if (!get(1, in, end, control))
+            {
+                return false;
+            }
+            bits_type y = 0;
+            if (control != 0)
+            {
+                if (!get(1, in, end, control))
+                {
+                    return false;
+                }
+                int leading = leading_;
+                int trailing = trailing_;
+                if (control != 0)
+                {
+                    std::uint64_t l, length;
+                    if (!get(LEADING_BITS, in, end, l) || !get(LENGTH_BITS, in, end, length))
+                    {
+                        return false;
+                    }
+                    leading = l;
+                    trailing = BITS - leading - (int)length - 1;
+                    if (trailing < 0)
+                    {
+                        throw std::runtime_error("XorDecoder: malformed encoding.");
+                    }
+                }
+                else if (leading_ < 0)
+                {
+                    throw std::runtime_error("XorDecoder: malformed encoding.");
+                }
+                std::uint64_t meaningful;
+                if (!get(BITS - leading - trailing, in, end, meaningful))
+                {
+                    return false;
+                }
+                y = static_cast<bits_type>(meaningful) << trailing;
+                leading_ = leading;
+                trailing_ = trailing;
+            }
+            previous_ ^= y;
+            out = std::bit_cast<T>(previous_);
+            return true;
+        }
+
+        bool get(const int n, const std::byte*& in, const std::byte* end, std::uint64_t& v)
+        {
+            if (n > 32)
+            {
+                std::uint64_t high, low;
+                if (!get(n - 32, in, end, high) || !get(32, in, end, low))
+                {
+                    return false;
+                }
+                v = (high << 32) | low;
+                return true;
+            }
+            while (available_ <= 56 && in != end)
+            {
+                buffer_ |= static_cast<std::uint64_t>(*in++) << (56 - available_);
+                available_ += 8;
+            }
+            if (available_ < n)
+            {
+                return false;
+            }
+            v = buffer_ >> (64 - n);
+            buffer_ <<= n;
+            available_ -= n;
+            return true;
+        }
+
+        bits_type previous_;
+        int leading_;
+        int trailing_;
+        std::uint64_t buffer_;
+        int available_;
+    };
+}
+
+#endif // ALS_UTILITIES_ENCODINGS_HPP
@@ -11,12 +11,82 @@
  * @a read_from_file follows the following syntax:
  * read_from_file(reference to the object, FILE pointer to your file)
  * 
+ * Instead of a FILE pointer, any of the sinks and sources of Streams.hpp can be
+ * used (buffered file descriptors, memory buffers...).
+ * 
+ * The sizes of containers and strings are stored with the width given by the
+ * format of the stream (see @a stream_format ): 32 bits for FILE pointers and
+ * plain streams, which is the original layout, and 64 bits by default for
+ * archives (see Archive.hpp). Sizes that do not fit in 32 bits throw
+ * std::length_error instead of being truncated.
+ * 
+ * In archives, vectors and deques of numbers also carry the encoding of their
+ * elements (see Encodings.hpp), which can be chosen with @a encoded or, for
+ * integers, with ArchiveSink::set_integer_encoding .
+ * 
+ * In archives, vectors of strings are split into blocks of about
+ * FILE_OPERATIONS_CHUNK_SIZE bytes that store the sizes of their strings first
+ * and then their characters, so that they can be read with a few large reads
+ * and written a block at a time (see @a has_batched_strings ).
+ * 
+ * Archives may store numbers in the opposite byte order or, if they are portable,
+ * with fixed widths (see Archive.hpp). Such numbers are converted whole arrays at
+ * a time through a staging buffer; otherwise, they are copied as they are.
+ * 
  * Currently, we offer support for basic C types, strings, complex numbers,
- * std:array, std::vector, std::deque, std::forward_list, std::list.
+ * std:array, std::vector, std::deque, std::forward_list, std::list, std::pair,
+ * std::set, std::multiset, std::map, std::multimap, std::unordered_set,
+ * std::unordered_multiset, std::unordered_map, std::unordered_multimap.
+ * 
+ * Containers and strings with any allocator are supported. In particular, nested
+ * std::pmr containers read with @a read_from_file take all their memory from the
+ * resource of the outer one, so that a whole state can be restored into an arena
+ * and freed at once:
+ * 
+ * std::pmr::monotonic_buffer_resource arena;
+ * auto rows = read_from_file<std::pmr::vector<std::pmr::vector<double>>>(source, &arena);
+ * 
+ * Sets and maps are written in the order in which they iterate over their
+ * elements, and are rebuilt with hinted insertions at the end, which takes
+ * linear time for ordered containers. Unordered containers reserve room for
+ * all their elements before inserting them.
  * 
  * In order to define @a write_to_file and @a read_from_file for your
  * custom objects, it suffices to implement the public methods
  * write_to_file(FILE* file) and read_from_file(FILE* file).
+ * If you want to use them with other streams, make these methods templates
+ * on the type of the stream, i.e. write_to_file(Stream& stream).
+ * Trivially copyable types that do not implement these methods (for instance,
+ * plain structs) are saved as a raw copy of their bytes.
+ * 
+ * Alternatively, the macro ALS_UTILITIES_FILE_FIELDS generates both methods from
+ * a list of the fields of a class, which are written one after another:
+ * 
+ * struct Record
+ * {
+ *     double x, y;
+ *     std::int32_t id;
+ *     std::uint32_t flags;
+ *     ALS_UTILITIES_FILE_FIELDS(x, y, id, flags)
+ * };
+ * 
+ * If such a class is trivially copyable, all its fields are bitwise serializable
+ * and, listed in declaration order, they fill the class without padding (see
+ * @a is_packed_record ), writing its fields one after another is the same as
+ * copying its bytes. Then, it is bitwise serializable too, so single objects are
+ * copied with a single write and containers of them take the bulk path. Otherwise,
+ * the fields are written one by one.
+ * 
+ * Containers of trivially copyable elements (see @a is_bitwise_serializable )
+ * that store them contiguously are written with a single write and read back
+ * with a few large reads, without value-initialising them.
+ * Vectors of such elements can also be written with @a write_aligned_to_file , which
+ * pads the file so that their elements can be used in place from a memory mapping
+ * (see MappedFile.hpp).
+ * 
+ * @a serialized_size returns the number of bytes that @a write_to_file would write,
+ * in constant time for containers of bitwise serializable elements, so that files
+ * and buffers can be allocated beforehand.
  * 
  * @todo Add support for other standard containers!
  */
@@ -26,7 +96,18 @@
 #define ALS_UTILITIES_FILE_OPERATIONS_HPP
 
 #include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 
+#include <bit>
+#include <stdexcept>
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
 #include <string>
 #include <complex>
 #include <array>
@@ -34,326 +115,2502 @@
 #include <deque>
 #include <forward_list>
 #include <list>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
+#include <tuple>
+
+#include "ByteOrder.hpp"
+#include "Encodings.hpp"
+#include "Streams.hpp"
 
 namespace als::utilities
 {
-    // Writing operations.
-    void inline write_to_file(const signed char& val, FILE* file)
+    template <class Container>
+    struct EncodedContainer;
+
+    // Declarations of the templated overloads, so that they can call each
+    // other regardless of the order in which they are defined below.
+    template <class K, class Stream>
+    void write_to_file(const std::complex<K>& z, Stream&& stream);
+    template <class T, size_t N, class Stream>
+    void write_to_file(const std::array<T, N>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void write_to_file(const std::vector<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void write_to_file(const std::deque<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void write_to_file(const std::forward_list<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void write_to_file(const std::list<T, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Stream>
+    void write_to_file(const std::pair<K, V>& object, Stream&& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    void write_to_file(const std::set<K, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    void write_to_file(const std::multiset<K, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void write_to_file(const std::map<K, V, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void write_to_file(const std::multimap<K, V, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void write_to_file(const std::unordered_set<K, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void write_to_file(const std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void write_to_file(const std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void write_to_file(const std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class Container, class Stream>
+    void write_to_file(const EncodedContainer<Container>& object, Stream&& stream);
+    template <class T, class Stream>
+    void write_to_file(const T& object, Stream&& stream);
+
+    template <class K, class Stream>
+    void read_from_file(std::complex<K>& z, Stream&& stream);
+    template <class T, size_t N, class Stream>
+    void read_from_file(std::array<T, N>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void read_from_file(std::vector<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void read_from_file(std::deque<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void read_from_file(std::forward_list<T, Allocator>& object, Stream&& stream);
+    template <class T, class Allocator, class Stream>
+    void read_from_file(std::list<T, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Stream>
+    void read_from_file(std::pair<K, V>& object, Stream&& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    void read_from_file(std::set<K, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    void read_from_file(std::multiset<K, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void read_from_file(std::map<K, V, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void read_from_file(std::multimap<K, V, Compare, Allocator>& object, Stream&& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void read_from_file(std::unordered_set<K, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void read_from_file(std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void read_from_file(std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void read_from_file(std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream);
+    template <class T, class Stream>
+    void read_from_file(T& object, Stream&& stream);
+
+    template <class K, class Stream>
+    size_t serialized_size(const std::complex<K>& z, const Stream& stream);
+    template <class T, size_t N, class Stream>
+    size_t serialized_size(const std::array<T, N>& object, const Stream& stream);
+    template <class T, class Allocator, class Stream>
+    size_t serialized_size(const std::vector<T, Allocator>& object, const Stream& stream);
+    template <class T, class Allocator, class Stream>
+    size_t serialized_size(const std::deque<T, Allocator>& object, const Stream& stream);
+    template <class T, class Allocator, class Stream>
+    size_t serialized_size(const std::forward_list<T, Allocator>& object, const Stream& stream);
+    template <class T, class Allocator, class Stream>
+    size_t serialized_size(const std::list<T, Allocator>& object, const Stream& stream);
+    template <class K, class V, class Stream>
+    size_t serialized_size(const std::pair<K, V>& object, const Stream& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    size_t serialized_size(const std::set<K, Compare, Allocator>& object, const Stream& stream);
+    template <class K, class Compare, class Allocator, class Stream>
+    size_t serialized_size(const std::multiset<K, Compare, Allocator>& object, const Stream& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    size_t serialized_size(const std::map<K, V, Compare, Allocator>& object, const Stream& stream);
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    size_t serialized_size(const std::multimap<K, V, Compare, Allocator>& object, const Stream& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t serialized_size(const std::unordered_set<K, Hash, KeyEqual, Allocator>& object, const Stream& stream);
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t serialized_size(const std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, const Stream& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t serialized_size(const std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, const Stream& stream);
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t serialized_size(const std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, const Stream& stream);
+    template <class Container, class Stream>
+    size_t serialized_size(const EncodedContainer<Container>& object, const Stream& stream);
+    template <class T, class Stream>
+    size_t serialized_size(const T& object, const Stream& stream);
+
+    /**
+     * @brief Checks whether T implements the public method write_to_file(FILE* file),
+     * either directly or as a template on the type of the stream.
+     * 
+     * @tparam T 
+     */
+    template <class T, class = void>
+    struct has_write_to_file_method : std::false_type {};
+
+    template <class T>
+    struct has_write_to_file_method<T, std::void_t<decltype(
+        std::declval<const T&>().write_to_file(std::declval<FILE*&>()))>> : std::true_type {};
+
+    /**
+     * @brief Checks whether the file representation of T is just a copy of its bytes.
+     * 
+     * This is the case for trivially copyable types that do not implement their own
+     * write_to_file method, such as arithmetic types, complex numbers or plain structs.
+     * Booleans are excluded because they are stored packed inside std::vector, and pointers
+     * because their value is meaningless once the program exits. Classes whose fields
+     * are listed with ALS_UTILITIES_FILE_FIELDS are included if they have no padding
+     * (see @a is_packed_record ).
+     * 
+     * @tparam T 
+     */
+    template <class T>
+    struct is_bitwise_serializable;
+
+    /**
+     * @brief Checks whether T lists its fields with ALS_UTILITIES_FILE_FIELDS .
+     * 
+     * @tparam T 
+     */
+    template <class T, class = void>
+    struct has_file_fields : std::false_type {};
+
+    template <class T>
+    struct has_file_fields<T, std::void_t<decltype(std::declval<const T&>().file_fields())>> : std::true_type {};
+
+    template <class T, class Stream>
+    bool needs_conversion(const Stream& stream);
+
+    template <class T, class Stream>
+    size_t serialized_element_size(const Stream& stream);
+
+    template <class Fields>
+    struct packed_fields;
+
+    template <class... Fields>
+    struct packed_fields<std::tuple<Fields...>>
+    {
+        static constexpr size_t size = (sizeof(std::remove_cvref_t<Fields>) + ... + 0);
+        static constexpr bool bitwise = (is_bitwise_serializable<std::remove_cvref_t<Fields>>::value && ...);
+
+        template <class Stream>
+        static bool needs_conversion(const Stream& stream)
+        {
+            return (als::utilities::needs_conversion<std::remove_cvref_t<Fields>>(stream) || ...);
+        }
+
+        template <class Stream>
+        static size_t serialized_size(const Stream& stream)
+        {
+            return (als::utilities::serialized_element_size<std::remove_cvref_t<Fields>>(stream) + ... + 0);
+        }
+    };
+
+    // Never defined: it only provides the addresses of the fields at compile time.
+    template <class T>
+    extern const T file_fields_probe;
+
+    template <class T>
+    constexpr bool fields_fill_object()
+    {
+        using Fields = packed_fields<decltype(std::declval<const T&>().file_fields())>;
+        if constexpr (!std::is_trivially_copyable_v<T> || !Fields::bitwise || Fields::size != sizeof(T))
+        {
+            return false;
+        }
+        else
+        {
+            // Distinct fields in increasing order of address whose sizes add up to
+            // sizeof(T) leave no gaps, so each one starts where the previous one ends.
+            return std::apply([](const auto&... fields)
+            {
+                const void* addresses[] = {static_cast<const void*>(&fields)...};
+                for (size_t i = 1; i < sizeof...(fields); i++)
+                {
+                    if (!(addresses[i - 1] < addresses[i]))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }, file_fields_probe<T>.file_fields());
+        }
+    }
+
+    /**
+     * @brief Checks whether T lists its fields with ALS_UTILITIES_FILE_FIELDS , is
+     * trivially copyable and its fields are bitwise serializable, are listed in
+     * declaration order and take all its bytes, i.e. each field starts right where
+     * the previous one ends and there is no padding. Then, writing its fields one
+     * after another is the same as copying its bytes.
+     * 
+     * @tparam T 
+     */
+    template <class T, class = void>
+    struct is_packed_record : std::false_type {};
+
+    template <class T>
+    struct is_packed_record<T, std::enable_if_t<has_file_fields<T>::value>>
+        : std::bool_constant<fields_fill_object<T>()> {};
+
+    template <class T>
+    inline constexpr bool is_packed_record_v = is_packed_record<T>::value;
+
+/**
+ * @brief Generates the methods write_to_file and read_from_file of a class, which
+ * write and read the given fields in order, the method serialized_size, which
+ * adds up their sizes (see @a serialized_size ), and the method file_fields, which
+ * returns a tuple of references to them. Use it inside the definition of the class.
+ */
+#define ALS_UTILITIES_FILE_FIELDS(...) \
+    constexpr auto file_fields() const { return std::tie(__VA_ARGS__); } \
+    constexpr auto file_fields() { return std::tie(__VA_ARGS__); } \
+    template <class Stream> \
+    void write_to_file(Stream& stream) const \
+    { \
+        std::apply([&](const auto&... fields) { (::als::utilities::write_to_file(fields, stream), ...); }, \
+            file_fields()); \
+    } \
+    template <class Stream> \
+    void read_from_file(Stream& stream) \
+    { \
+        std::apply([&](auto&... fields) { (::als::utilities::read_from_file(fields, stream), ...); }, \
+            file_fields()); \
+    } \
+    template <class Stream> \
+    size_t serialized_size(const Stream& stream) const \
+    { \
+        return std::apply([&](const auto&... fields) \
+            { return (::als::utilities::serialized_size(fields, stream) + ... + size_t(0)); }, file_fields()); \
+    }
+
+    template <class T>
+    struct is_bitwise_serializable : std::bool_constant<(std::is_trivially_copyable_v<T>
+        && !std::is_same_v<std::remove_cv_t<T>, bool> && !std::is_pointer_v<T>
+        && !has_write_to_file_method<T>::value) || is_packed_record<T>::value> {};
+
+    template <class T, size_t N>
+    struct is_bitwise_serializable<std::array<T, N>> : is_bitwise_serializable<T> {};
+
+    template <class T>
+    inline constexpr bool is_bitwise_serializable_v = is_bitwise_serializable<T>::value;
+
+    /**
+     * @brief Describes the numbers that make up a bitwise serializable type, which
+     * are converted when the byte order or the widths of a stream differ from those
+     * of the machine (see @a needs_conversion ). type is the type of the numbers and
+     * count is the number of numbers in each object. For other types, such as plain
+     * structs, type is void and their bytes are copied as they are.
+     * 
+     * @tparam T 
+     */
+    template <class T, class = void>
+    struct number_components
+    {
+        using type = void;
+        static constexpr size_t count = 0;
+    };
+
+    template <class T>
+    struct number_components<T, std::enable_if_t<std::is_arithmetic_v<T>>>
+    {
+        using type = T;
+        static constexpr size_t count = 1;
+    };
+
+    template <class T>
+    struct number_components<T, std::enable_if_t<std::is_enum_v<T>>>
+    {
+        using type = std::underlying_type_t<T>;
+        static constexpr size_t count = 1;
+    };
+
+    template <class K>
+    struct number_components<std::complex<K>>
+    {
+        using type = typename number_components<K>::type;
+        static constexpr size_t count = 2 * number_components<K>::count;
+    };
+
+    template <class T, size_t N>
+    struct number_components<std::array<T, N>>
+    {
+        using type = typename number_components<T>::type;
+        static constexpr size_t count = N * number_components<T>::count;
+    };
+
+    /**
+     * @brief Representation of a number in portable archives (see FileFormat::portable):
+     * count consecutive objects of type type.
+     * 
+     * @tparam T an arithmetic type.
+     */
+    template <class T>
+    struct portable_number
+    {
+        using type = T;
+        static constexpr size_t count = 1;
+    };
+
+    template <>
+    struct portable_number<long>
+    {
+        using type = std::int64_t;
+        static constexpr size_t count = 1;
+    };
+
+    template <>
+    struct portable_number<unsigned long>
+    {
+        using type = std::uint64_t;
+        static constexpr size_t count = 1;
+    };
+
+    template <>
+    struct portable_number<wchar_t>
+    {
+        using type = std::conditional_t<std::is_signed_v<wchar_t>, std::int32_t, std::uint32_t>;
+        static constexpr size_t count = 1;
+    };
+
+    template <>
+    struct portable_number<long double>
+    {
+        using type = double;
+        static constexpr size_t count = 2;
+    };
+
+    /**
+     * @brief Checks whether the representation of a number in portable archives
+     * differs from its representation in memory, apart from the byte order.
+     * 
+     * @tparam T an arithmetic type.
+     */
+    template <class T>
+    inline constexpr bool has_portable_width_change_v = std::is_same_v<T, long double>
+        || sizeof(T) != sizeof(typename portable_number<T>::type);
+
+    /**
+     * @brief Checks whether the multi-byte numbers of a stream are stored in the
+     * opposite byte order to the one of this machine.
+     * 
+     * @param stream 
+     * @return true 
+     * @return false 
+     */
+    template <class Stream>
+    bool inline has_swapped_byte_order(const Stream& stream)
+    {
+        return stream_format(stream).little_endian != (std::endian::native == std::endian::little);
+    }
+
+    /**
+     * @brief Checks whether objects of type T must be converted to be written to
+     * or read from a stream, because their numbers are stored in the opposite byte
+     * order or with a different width. Otherwise, their bytes are copied as they are.
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param stream 
+     * @return true 
+     * @return false 
+     */
+    template <class T, class Stream>
+    bool inline needs_conversion(const Stream& stream)
     {
-        fwrite(&val, sizeof(signed char), 1, file);
+        using Number = typename number_components<T>::type;
+        if constexpr (has_file_fields<T>::value)
+        {
+            return packed_fields<decltype(std::declval<const T&>().file_fields())>::needs_conversion(stream);
+        }
+        else if constexpr (std::is_void_v<Number>)
+        {
+            return false;
+        }
+        else
+        {
+            const FileFormat format = stream_format(stream);
+            return (sizeof(Number) > 1 && format.little_endian != (std::endian::native == std::endian::little))
+                || (format.portable && has_portable_width_change_v<Number>);
+        }
     }
 
-    void inline write_to_file(const char& val, FILE* file)
+    /**
+     * @brief Returns the size in bytes of the file representation of an object of
+     * type T in a stream, which only differs from sizeof(T) in portable archives
+     * (see FileFormat::portable).
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param stream 
+     * @return size_t 
+     */
+    template <class T, class Stream>
+    size_t inline serialized_element_size(const Stream& stream)
     {
-        fwrite(&val, sizeof(char), 1, file);
+        using Number = typename number_components<T>::type;
+        if constexpr (has_file_fields<T>::value)
+        {
+            return packed_fields<decltype(std::declval<const T&>().file_fields())>::serialized_size(stream);
+        }
+        else if constexpr (!std::is_void_v<Number>)
+        {
+            if (has_portable_width_change_v<Number> && stream_format(stream).portable)
+            {
+                return number_components<T>::count * portable_number<Number>::count
+                    * sizeof(typename portable_number<Number>::type);
+            }
+        }
+        return sizeof(T);
     }
 
-    void inline write_to_file(const unsigned char& val, FILE* file)
+    /**
+     * @brief Size in bytes of the chunks in which containers of bitwise serializable
+     * objects are read when they cannot be read in place.
+     */
+    inline constexpr size_t FILE_OPERATIONS_CHUNK_SIZE = 1 << 20;
+
+    /**
+     * @brief Writes N contiguous objects whose numbers must be converted (see
+     * @a needs_conversion ), a chunk at a time.
+     * 
+     * @tparam T a bitwise serializable type made of numbers.
+     * @param data pointer to the first object.
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Stream>
+    void inline write_converted_array(const T* data, const size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(unsigned char), 1, file);
+        using Number = typename number_components<T>::type;
+        const FileFormat format = stream_format(stream);
+        const bool swap = (format.little_endian != (std::endian::native == std::endian::little));
+        const Number* numbers = reinterpret_cast<const Number*>(data);
+        size_t count = N * number_components<T>::count;
+        if (!format.portable || !has_portable_width_change_v<Number>)
+        {
+            // Only the byte order changes.
+            if constexpr (std::is_same_v<Number, long double>)
+            {
+                throw std::invalid_argument("write_to_file: long double can only be converted in portable archives.");
+            }
+            const size_t chunk = std::min(count, FILE_OPERATIONS_CHUNK_SIZE / sizeof(Number));
+            std::unique_ptr<Number[]> buffer(new Number[chunk]);
+            for (; count > 0; count -= std::min(count, chunk))
+            {
+                const size_t n = std::min(count, chunk);
+                swap_bytes(numbers, buffer.get(), n, sizeof(Number));
+                write_bytes(stream, buffer.get(), n * sizeof(Number));
+                numbers += n;
+            }
+            return;
+        }
+
+        using Unit = typename portable_number<Number>::type;
+        constexpr size_t UNITS = portable_number<Number>::count;
+        const size_t chunk = std::min(count, FILE_OPERATIONS_CHUNK_SIZE / (UNITS * sizeof(Unit)));
+        std::unique_ptr<Unit[]> buffer(new Unit[chunk * UNITS]);
+        for (; count > 0; count -= std::min(count, chunk))
+        {
+            const size_t n = std::min(count, chunk);
+            for (size_t i = 0; i < n; i++)
+            {
+                if constexpr (std::is_same_v<Number, long double>)
+                {
+                    // Stored as the sum of two doubles, which keeps 106 bits of mantissa.
+                    const double high = static_cast<double>(numbers[i]);
+                    buffer[2 * i] = high;
+                    buffer[2 * i + 1] = static_cast<double>(numbers[i] - high);
+                }
+                else
+                {
+                    buffer[i] = static_cast<Unit>(numbers[i]);
+                }
+            }
+            if (swap)
+            {
+                swap_bytes(buffer.get(), n * UNITS, sizeof(Unit));
+            }
+            write_bytes(stream, buffer.get(), n * UNITS * sizeof(Unit));
+            numbers += n;
+        }
     }
 
-    void inline write_to_file(const short int& val, FILE* file)
+    /**
+     * @brief Reads N contiguous objects whose numbers must be converted (see
+     * @a needs_conversion ). Throws std::runtime_error if a number does not fit
+     * in its type on this machine.
+     * 
+     * @tparam T a bitwise serializable type made of numbers.
+     * @param data pointer to the first object.
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Stream>
+    void inline read_converted_array(T* data, const size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(short int), 1, file);
+        using Number = typename number_components<T>::type;
+        const FileFormat format = stream_format(stream);
+        const bool swap = (format.little_endian != (std::endian::native == std::endian::little));
+        Number* numbers = reinterpret_cast<Number*>(data);
+        size_t count = N * number_components<T>::count;
+        if (!format.portable || !has_portable_width_change_v<Number>)
+        {
+            // Only the byte order changes, so the numbers are swapped in place.
+            if constexpr (std::is_same_v<Number, long double>)
+            {
+                throw std::runtime_error("read_from_file: long double can only be converted in portable archives.");
+            }
+            read_bytes(stream, numbers, count * sizeof(Number));
+            swap_bytes(numbers, count, sizeof(Number));
+            return;
+        }
+
+        using Unit = typename portable_number<Number>::type;
+        constexpr size_t UNITS = portable_number<Number>::count;
+        const size_t chunk = std::min(count, FILE_OPERATIONS_CHUNK_SIZE / (UNITS * sizeof(Unit)));
+        std::unique_ptr<Unit[]> buffer(new Unit[chunk * UNITS]);
+        for (; count > 0; count -= std::min(count, chunk))
+        {
+            const size_t n = std::min(count, chunk);
+            read_bytes(stream, buffer.get(), n * UNITS * sizeof(Unit));
+            if (swap)
+            {
+                swap_bytes(buffer.get(), n * UNITS, sizeof(Unit));
+            }
+            for (size_t i = 0; i < n; i++)
+            {
+                if constexpr (std::is_same_v<Number, long double>)
+                {
+                    numbers[i] = static_cast<long double>(buffer[2 * i]) + buffer[2 * i + 1];
+                }
+                else
+                {
+                    numbers[i] = static_cast<Number>(buffer[i]);
+                    if (static_cast<Unit>(numbers[i]) != buffer[i])
+                    {
+                        throw std::runtime_error("read_from_file: the number does not fit in its type on this machine.");
+                    }
+                }
+            }
+            numbers += n;
+        }
     }
 
-    void inline write_to_file(const unsigned short int& val, FILE* file)
+    /**
+     * @brief Writes N contiguous objects with a single write, unless their numbers
+     * must be converted for the stream (see @a needs_conversion ).
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param data pointer to the first object.
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Stream>
+    void inline write_array_to_file(const T* data, const size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(unsigned short int), 1, file);
+        static_assert(is_bitwise_serializable_v<T>,
+            "write_array_to_file requires a bitwise serializable type.");
+        if (N > 0)
+        {
+            if (needs_conversion<T>(stream))
+            {
+                if constexpr (has_file_fields<T>::value)
+                {
+                    // Packed records are converted field by field.
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        data[i].write_to_file(stream);
+                    }
+                }
+                else if constexpr (!std::is_void_v<typename number_components<T>::type>)
+                {
+                    write_converted_array(data, N, stream);
+                }
+            }
+            else
+            {
+                write_bytes(stream, data, N * sizeof(T));
+            }
+        }
     }
 
-    void inline write_to_file(const int& val, FILE* file)
+    /**
+     * @brief Reads N contiguous objects with a single read, unless their numbers
+     * must be converted for the stream (see @a needs_conversion ).
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param data pointer to the first object.
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Stream>
+    void inline read_array_from_file(T* data, const size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(int), 1, file);
+        static_assert(is_bitwise_serializable_v<T>,
+            "read_array_from_file requires a bitwise serializable type.");
+        if (N > 0)
+        {
+            if (needs_conversion<T>(stream))
+            {
+                if constexpr (has_file_fields<T>::value)
+                {
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        data[i].read_from_file(stream);
+                    }
+                }
+                else if constexpr (!std::is_void_v<typename number_components<T>::type>)
+                {
+                    read_converted_array(data, N, stream);
+                }
+            }
+            else
+            {
+                read_bytes(stream, data, N * sizeof(T));
+            }
+        }
     }
 
-    void inline write_to_file(const unsigned int& val, FILE* file)
+    /**
+     * @brief Reads N objects and appends them at the end of a container.
+     * 
+     * The objects are read in chunks of FILE_OPERATIONS_CHUNK_SIZE bytes through
+     * a temporary buffer, so that the container never value-initialises them.
+     * 
+     * @tparam T a bitwise serializable type.
+     * @tparam Container a sequence container of T.
+     * @param object 
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Container, class Stream>
+    void inline append_array_from_file(Container& object, size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(unsigned int), 1, file);
+        if (N == 0)
+        {
+            return;
+        }
+        constexpr size_t LOCAL_BYTES = 4096;
+        if constexpr (sizeof(T) <= LOCAL_BYTES)
+        {
+            // Small containers go through a buffer on the stack, so that reading
+            // many of them does not allocate temporary memory.
+            if (N * sizeof(T) <= LOCAL_BYTES)
+            {
+                T local[LOCAL_BYTES / sizeof(T)];
+                read_array_from_file(local, N, stream);
+                object.insert(object.end(), local, local + N);
+                return;
+            }
+        }
+        const size_t chunk = std::min(N, std::max<size_t>(1, FILE_OPERATIONS_CHUNK_SIZE / sizeof(T)));
+        std::unique_ptr<T[]> buffer(new T[chunk]);
+        while (N > 0)
+        {
+            const size_t n = std::min(N, chunk);
+            read_array_from_file(buffer.get(), n, stream);
+            object.insert(object.end(), buffer.get(), buffer.get() + n);
+            N -= n;
+        }
     }
 
-    void inline write_to_file(const long int& val, FILE* file)
+    /**
+     * @brief Replaces the contents of a vector with N objects read from a stream.
+     * 
+     * The elements that are already in the vector are overwritten in place
+     * and the rest are appended, so that no element is value-initialised.
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param object 
+     * @param N number of objects.
+     * @param stream 
+     */
+    template <class T, class Allocator, class Stream>
+    void inline read_array_from_file(std::vector<T, Allocator>& object, const size_t N, Stream&& stream)
     {
-        fwrite(&val, sizeof(long int), 1, file);
+        const size_t reused = std::min(object.size(), N);
+        object.resize(reused);
+        read_array_from_file(object.data(), reused, stream);
+        object.reserve(N);
+        append_array_from_file<T>(object, N - reused, stream);
     }
 
-    void inline write_to_file(const unsigned long int& val, FILE* file)
+    /**
+     * @brief Writes the size of a container or a string with the width given
+     * by the format of the stream.
+     * 
+     * @param size 
+     * @param stream 
+     */
+    template <class Stream>
+    void inline write_size_to_file(const size_t size, Stream&& stream)
     {
-        fwrite(&val, sizeof(unsigned long int), 1, file);
+        if (stream_format(stream).size_width == 8)
+        {
+            const std::uint64_t size64 = size;
+            write_array_to_file(&size64, 1, stream);
+        }
+        else
+        {
+            if (size > UINT32_MAX)
+            {
+                throw std::length_error("write_to_file: the size does not fit in 32 bits; "
+                    "use an archive with 64-bit sizes (see Archive.hpp).");
+            }
+            const std::uint32_t size32 = size;
+            write_array_to_file(&size32, 1, stream);
+        }
     }
 
-    void inline write_to_file(const long long int& val, FILE* file)
+    /**
+     * @brief Reads the size of a container or a string with the width given
+     * by the format of the stream.
+     * 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Stream>
+    size_t inline read_size_from_file(Stream&& stream)
     {
-        fwrite(&val, sizeof(long long int), 1, file);
+        if (stream_format(stream).size_width == 8)
+        {
+            std::uint64_t size64;
+            read_array_from_file(&size64, 1, stream);
+            return size64;
+        }
+        else
+        {
+            std::uint32_t size32;
+            read_array_from_file(&size32, 1, stream);
+            return size32;
+        }
     }
 
-    void inline write_to_file(const unsigned long long int& val, FILE* file)
+    /**
+     * @brief Checks whether containers of numbers written to a stream carry an
+     * encoding tag, which happens in archives of version 2 or later.
+     * 
+     * @param stream 
+     * @return true 
+     * @return false 
+     */
+    template <class Stream>
+    bool inline has_encoding_tags(const Stream& stream)
     {
-        fwrite(&val, sizeof(unsigned long long int), 1, file);
+        return stream_format(stream).version >= 2;
     }
 
-    void inline write_to_file(const float& val, FILE* file)
+    /**
+     * @brief Returns the encoding of the containers of T written to a stream.
+     * Streams can choose the encoding of integers with the public method
+     * integer_encoding(); the rest of numbers are not encoded.
+     * 
+     * @tparam T 
+     * @param stream 
+     * @return Encoding 
+     */
+    template <class T, class Stream>
+    Encoding inline default_encoding(const Stream& stream)
     {
-        fwrite(&val, sizeof(float), 1, file);
+        if constexpr (std::is_integral_v<T> && requires { stream.integer_encoding(); })
+        {
+            return stream.integer_encoding();
+        }
+        else
+        {
+            return Encoding::RAW;
+        }
     }
 
-    void inline write_to_file(const double& val, FILE* file)
+    /**
+     * @brief A container written with a given encoding (see @a encoded ).
+     * 
+     * @tparam Container a std::vector or a std::deque of numbers.
+     */
+    template <class Container>
+    struct EncodedContainer
+    {
+        const Container& container;
+        Encoding encoding;
+    };
+
+    /**
+     * @brief Returns an object that makes @a write_to_file write a container with
+     * the given encoding. The stream must be an archive of version 2 or later.
+     * The container is read back with @a read_from_file as usual.
+     * 
+     * For example: write_to_file(encoded(indices, Encoding::DELTA_VARINT), archive)
+     * or write_to_file(encoded(prices, Encoding::XOR), archive).
+     * 
+     * @tparam Container a std::vector or a std::deque of numbers.
+     * @param container 
+     * @param encoding 
+     * @return EncodedContainer<Container> 
+     */
+    template <class Container>
+    EncodedContainer<Container> inline encoded(const Container& container, const Encoding encoding)
     {
-        fwrite(&val, sizeof(double), 1, file);
+        return EncodedContainer<Container>{container, encoding};
     }
 
-    void inline write_to_file(const long double& val, FILE* file)
+    /**
+     * @brief Calls f(data, N) for each run of N contiguous elements of a container.
+     * 
+     * @tparam T 
+     * @tparam Function 
+     * @param object 
+     * @param f 
+     */
+    template <class T, class Allocator, class Function>
+    void inline for_each_block(const std::vector<T, Allocator>& object, Function&& f)
     {
-        fwrite(&val, sizeof(long double), 1, file);
+        f(object.data(), object.size());
     }
 
-    void inline write_to_file(const wchar_t& val, FILE* file)
+    template <class T, class Allocator, class Function>
+    void inline for_each_block(const std::deque<T, Allocator>& object, Function&& f)
     {
-        fwrite(&val, sizeof(wchar_t), 1, file);
+        // A deque stores its elements in fixed-size blocks. We look for the
+        // runs of contiguous elements.
+        auto it = object.begin();
+        while (it != object.end())
+        {
+            const T* block = &*it;
+            size_t length = 1;
+            for (++it; it != object.end() && &*it == block + length; ++it)
+            {
+                length++;
+            }
+            f(block, length);
+        }
     }
 
-    void inline write_to_file(const bool& val, FILE* file)
+    /**
+     * @brief Writes the elements of a vector or a deque of numbers with an encoder
+     * (see Encodings.hpp), preceded by the number of bytes of the encoding.
+     * 
+     * @tparam Container 
+     * @tparam Encoder 
+     * @param object 
+     * @param measurer an encoder used to measure the encoding.
+     * @param encoder an encoder in the same state as measurer.
+     * @param stream 
+     */
+    template <class Container, class Encoder, class Stream>
+    void inline write_encoded_payload(const Container& object, Encoder& measurer, Encoder& encoder, Stream&& stream)
     {
-        write_to_file((char) val, file);
+        using T = typename Container::value_type;
+        for_each_block(object, [&](const T* data, const size_t N)
+        {
+            measurer.measure(data, N);
+        });
+        const std::uint64_t bytes = measurer.measured_bytes();
+        write_array_to_file(&bytes, 1, stream);
+
+        // We encode the elements a chunk at a time.
+        const size_t chunk = std::min(object.size(), FILE_OPERATIONS_CHUNK_SIZE / Encoder::MAX_CODE_SIZE);
+        std::unique_ptr<std::byte[]> buffer(new std::byte[chunk * Encoder::MAX_CODE_SIZE + 8]);
+        for_each_block(object, [&](const T* data, const size_t N)
+        {
+            for (size_t i = 0; i < N; i += chunk)
+            {
+                const std::byte* end = encoder.encode(data + i, std::min(chunk, N - i), buffer.get());
+                write_bytes(stream, buffer.get(), end - buffer.get());
+            }
+        });
+        const std::byte* end = encoder.finish(buffer.get());
+        write_bytes(stream, buffer.get(), end - buffer.get());
     }
 
-    void inline write_to_file(const std::string& str, FILE* file)
+    /**
+     * @brief Writes the encoding tag and the elements of a vector or a deque of numbers.
+     * 
+     * @tparam Container 
+     * @param object 
+     * @param encoding 
+     * @param stream 
+     */
+    template <class Container, class Stream>
+    void inline write_encoded_elements(const Container& object, const Encoding encoding, Stream&& stream)
     {
-        write_to_file((unsigned int)str.size(), file);
-        fwrite(str.c_str(), sizeof(char), str.size()+1, file);
+        using T = typename Container::value_type;
+        if (!is_valid_encoding<T>(encoding))
+        {
+            throw std::invalid_argument("write_to_file: invalid encoding for this type.");
+        }
+        write_bytes(stream, &encoding, 1);
+        if (encoding == Encoding::RAW)
+        {
+            for_each_block(object, [&](const T* data, const size_t N)
+            {
+                write_array_to_file(data, N, stream);
+            });
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            const bool delta = (encoding == Encoding::DELTA_VARINT);
+            VarintEncoder<T> measurer(delta), encoder(delta);
+            write_encoded_payload(object, measurer, encoder, stream);
+        }
+        else
+        {
+            XorEncoder<T> measurer, encoder;
+            write_encoded_payload(object, measurer, encoder, stream);
+        }
     }
 
-    template <class K>
-    void inline write_to_file(const std::complex<K>& z, FILE* file)
+    /**
+     * @brief Reads N elements of a vector or a deque of numbers written by
+     * @a write_encoded_payload with a decoder (see Encodings.hpp), replacing
+     * its contents.
+     * 
+     * @tparam Container 
+     * @tparam Decoder 
+     * @param object 
+     * @param N 
+     * @param decoder 
+     * @param stream 
+     */
+    template <class Container, class Decoder, class Stream>
+    void inline read_encoded_payload(Container& object, const size_t N, Decoder& decoder, Stream&& stream)
     {
-        write_to_file(z.real(), file);
-        write_to_file(z.imag(), file);
+        using T = typename Container::value_type;
+        std::uint64_t bytes;
+        read_array_from_file(&bytes, 1, stream);
+        object.clear();
+        if constexpr (std::is_same_v<Container, std::vector<T, typename Container::allocator_type>>)
+        {
+            object.reserve(N);
+        }
+
+        // The encoding is read a chunk at a time and decoded straight into the
+        // container. An element may be split between two chunks, so the bytes
+        // that could not be decoded are carried over.
+        const size_t input_size = std::min<std::uint64_t>(bytes, FILE_OPERATIONS_CHUNK_SIZE) + Decoder::MAX_CODE_SIZE;
+        const size_t output_size = std::min(N, std::max<size_t>(1, FILE_OPERATIONS_CHUNK_SIZE / sizeof(T)));
+        std::unique_ptr<std::byte[]> input(new std::byte[input_size]);
+        std::unique_ptr<T[]> output(new T[output_size]);
+        size_t available = 0;
+        while (object.size() < N)
+        {
+            const size_t n = std::min<std::uint64_t>(bytes, input_size - available);
+            read_bytes(stream, input.get() + available, n);
+            bytes -= n;
+            available += n;
+
+            const std::byte* in = input.get();
+            const std::byte* end = in + available;
+            size_t decoded = 0;
+            size_t m;
+            do
+            {
+                m = decoder.decode(in, end, output.get(), std::min(output_size, N - object.size()));
+                object.insert(object.end(), output.get(), output.get() + m);
+                decoded += m;
+            } while (m > 0 && object.size() < N);
+
+            if (n == 0 && decoded == 0)
+            {
+                throw std::runtime_error("read_from_file: truncated encoding.");
+            }
+            available = end - in;
+            std::memmove(input.get(), in, available);
+        }
+        if (available > 0 || bytes > 0 || !decoder.finished())
+        {
+            throw std::runtime_error("read_from_file: malformed encoding.");
+        }
     }
 
-    template <class T, size_t N>
-    void inline write_to_file(const std::array<T, N>& object, FILE* file)
+    /**
+     * @brief Reads the encoding tag and N elements of a vector or a deque of numbers,
+     * replacing its contents.
+     * 
+     * @tparam Container 
+     * @param object 
+     * @param N 
+     * @param stream 
+     */
+    template <class Container, class Stream>
+    void inline read_encoded_elements(Container& object, const size_t N, Stream&& stream)
     {
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        using T = typename Container::value_type;
+        Encoding encoding;
+        read_bytes(stream, &encoding, 1);
+        if (!is_valid_encoding<T>(encoding))
+        {
+            throw std::runtime_error("read_from_file: unknown encoding.");
+        }
+        if (encoding == Encoding::RAW)
+        {
+            if constexpr (std::is_same_v<Container, std::vector<T, typename Container::allocator_type>>)
+            {
+                read_array_from_file(object, N, stream);
+            }
+            else
+            {
+                object.clear();
+                append_array_from_file<T>(object, N, stream);
+            }
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            VarintDecoder<T> decoder(encoding == Encoding::DELTA_VARINT);
+            read_encoded_payload(object, N, decoder, stream);
+        }
+        else
         {
-            write_to_file(*it, file);
+            XorDecoder<T> decoder;
+            read_encoded_payload(object, N, decoder, stream);
         }
     }
 
+    /**
+     * @brief Checks whether T is a string of char, whichever its allocator.
+     * 
+     * @tparam T 
+     */
     template <class T>
-    void inline write_to_file(const std::vector<T>& object, FILE* file)
+    inline constexpr bool is_char_string_v = false;
+
+    template <class Traits, class Allocator>
+    inline constexpr bool is_char_string_v<std::basic_string<char, Traits, Allocator>> = true;
+
+    /**
+     * @brief Checks whether vectors of strings written to a stream are split into
+     * blocks that store the sizes of their strings together and then their
+     * characters, which happens in archives of version 3 or later. Each block
+     * holds the number of its strings, their sizes and their characters, without
+     * terminators. A block takes consecutive strings while its sizes and characters
+     * fit in FILE_OPERATIONS_CHUNK_SIZE bytes, and at least one.
+     * 
+     * @tparam Stream 
+     * @param stream 
+     * @return true 
+     * @return false 
+     */
+    template <class Stream>
+    bool inline has_batched_strings(const Stream& stream)
+    {
+        return stream_format(stream).version >= 3;
+    }
+
+    /**
+     * @brief Returns the end of the block of strings that starts at first (see
+     * @a has_batched_strings ).
+     * 
+     * @param object 
+     * @param first 
+     * @param width size in bytes of each size.
+     * @return size_t 
+     */
+    template <class String, class Allocator>
+    size_t inline string_block_end(const std::vector<String, Allocator>& object, const size_t first, const size_t width)
     {
-        write_to_file((unsigned int)object.size(), file);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        size_t end = first + 1;
+        size_t bytes = width + object[first].size();
+        while (end < object.size() && bytes + width + object[end].size() <= FILE_OPERATIONS_CHUNK_SIZE)
         {
-            write_to_file(*it, file);
+            bytes += width + object[end++].size();
         }
+        return end;
     }
 
-    template <class T>
-    void inline write_to_file(const std::deque<T>& object, FILE* file)
+    /**
+     * @brief Writes a block of strings (see @a has_batched_strings ): the number
+     * of strings, their sizes with the width given by the format of the stream and
+     * their characters.
+     * 
+     * @param sizes 
+     * @param N number of strings.
+     * @param characters 
+     * @param bytes number of characters.
+     * @param stream 
+     */
+    template <class Stream>
+    void inline write_string_block(const std::uint64_t* sizes, const size_t N, const char* characters,
+        const size_t bytes, Stream&& stream)
     {
-        write_to_file((unsigned int)object.size(), file);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        write_size_to_file(N, stream);
+        if (stream_format(stream).size_width == 8)
+        {
+            write_array_to_file(sizes, N, stream);
+        }
+        else
         {
-            write_to_file(*it, file);
+            std::vector<std::uint32_t> narrow(N);
+            for (size_t i = 0; i < N; i++)
+            {
+                if (sizes[i] > UINT32_MAX)
+                {
+                    throw std::length_error("write_to_file: the size does not fit in 32 bits.");
+                }
+                narrow[i] = sizes[i];
+            }
+            write_array_to_file(narrow.data(), N, stream);
         }
+        write_bytes(stream, characters, bytes);
     }
 
-    template <class T>
-    void inline write_to_file(const std::forward_list<T>& object, FILE* file)
+    /**
+     * @brief Reads the number of strings of a block and their sizes (see
+     * @a has_batched_strings ). Throws std::runtime_error if the block is empty
+     * or has more than the remaining strings of the vector.
+     * 
+     * @param sizes replaced by the sizes of the strings of the block.
+     * @param remaining number of strings of the vector that have not been read yet.
+     * @param stream 
+     */
+    template <class Stream>
+    void inline read_string_block_sizes(std::vector<std::uint64_t>& sizes, const size_t remaining, Stream&& stream)
     {
-        write_to_file((unsigned int)object.size(), file);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        const size_t N = read_size_from_file(stream);
+        if (N == 0 || N > remaining)
         {
-            write_to_file(*it, file);
+            throw std::runtime_error("read_from_file: malformed vector of strings.");
+        }
+        sizes.resize(N);
+        if (stream_format(stream).size_width == 8)
+        {
+            read_array_from_file(sizes.data(), N, stream);
+        }
+        else
+        {
+            std::vector<std::uint32_t> narrow(N);
+            read_array_from_file(narrow.data(), N, stream);
+            std::copy(narrow.begin(), narrow.end(), sizes.begin());
         }
     }
 
-    template <class T>
-    void inline write_to_file(const std::list<T>& object, FILE* file)
+    /**
+     * @brief Writes the strings of a vector in blocks (see @a has_batched_strings ).
+     * 
+     * @param object 
+     * @param stream 
+     */
+    template <class String, class Allocator, class Stream>
+    void inline write_strings_to_file(const std::vector<String, Allocator>& object, Stream&& stream)
     {
-        write_to_file((unsigned int)object.size(), file);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        const size_t width = stream_format(stream).size_width == 8 ? 8 : 4;
+        std::vector<std::uint64_t> sizes;
+        std::string characters;
+        size_t i = 0;
+        while (i < object.size())
         {
-            write_to_file(*it, file);
+            const size_t end = string_block_end(object, i, width);
+            if (end == i + 1)
+            {
+                // Single strings, which may be long, are written in place.
+                const std::uint64_t size = object[i].size();
+                write_string_block(&size, 1, object[i].data(), object[i].size(), stream);
+                i++;
+                continue;
+            }
+            sizes.clear();
+            characters.clear();
+            for (; i < end; i++)
+            {
+                sizes.push_back(object[i].size());
+                characters.append(object[i].data(), object[i].size());
+            }
+            write_string_block(sizes.data(), sizes.size(), characters.data(), characters.size(), stream);
         }
     }
 
-    template <class T>
-    void inline write_to_file(const T& object, FILE* file)
+    /**
+     * @brief Reads N strings written by @a write_strings_to_file , replacing the
+     * contents of a vector. The capacity of the strings already in the vector is reused.
+     * 
+     * @param object 
+     * @param N 
+     * @param stream 
+     */
+    template <class String, class Allocator, class Stream>
+    void inline read_strings_from_file(std::vector<String, Allocator>& object, const size_t N, Stream&& stream)
     {
-        object.write_to_file(file);
+        object.resize(N);
+        std::vector<std::uint64_t> sizes;
+        std::unique_ptr<char[]> buffer;
+        size_t capacity = 0;
+        size_t i = 0;
+        while (i < N)
+        {
+            read_string_block_sizes(sizes, N - i, stream);
+
+            // The characters of consecutive strings are read into a staging buffer with
+            // a single call and then split. Long strings are read in place.
+            size_t j = 0;
+            while (j < sizes.size())
+            {
+                if (sizes[j] > FILE_OPERATIONS_CHUNK_SIZE)
+                {
+                    object[i].resize(sizes[j]);
+                    read_bytes(stream, object[i].data(), sizes[j]);
+                    i++;
+                    j++;
+                    continue;
+                }
+                size_t end = j;
+                size_t bytes = 0;
+                while (end < sizes.size() && bytes + sizes[end] <= FILE_OPERATIONS_CHUNK_SIZE)
+                {
+                    bytes += sizes[end++];
+                }
+                if (bytes > capacity)
+                {
+                    // The buffer grows as needed, so that vectors of a few short
+                    // strings do not allocate a whole chunk.
+                    buffer.reset(new char[bytes]);
+                    capacity = bytes;
+                }
+                if (bytes > 0)
+                {
+                    read_bytes(stream, buffer.get(), bytes);
+                }
+                const char* next = buffer.get();
+                for (; j < end; i++, j++)
+                {
+                    object[i].assign(next, sizes[j]);
+                    next += sizes[j];
+                }
+            }
+        }
     }
 
+    /**
+     * @brief Checks whether the elements of a set or a map are written as a raw
+     * copy of the bytes of their key (and their value), so that they can be
+     * staged in large blocks.
+     * 
+     * @tparam Container an associative container.
+     */
+    template <class Container>
+    inline constexpr bool has_bitwise_entries_v = []
+    {
+        if constexpr (requires { typename Container::mapped_type; })
+        {
+            return is_bitwise_serializable_v<typename Container::key_type>
+                && is_bitwise_serializable_v<typename Container::mapped_type>;
+        }
+        else
+        {
+            return is_bitwise_serializable_v<typename Container::key_type>;
+        }
+    }();
 
-    // Reading operations.
-    void inline read_from_file(char& val, FILE* file)
+    /**
+     * @brief Checks whether the keys or the values of a set or a map must be
+     * converted for a stream (see @a needs_conversion ).
+     * 
+     * @tparam Container an associative container.
+     * @param stream 
+     * @return true 
+     * @return false 
+     */
+    template <class Container, class Stream>
+    bool inline entries_need_conversion(const Stream& stream)
+    {
+        if constexpr (requires { typename Container::mapped_type; })
+        {
+            return needs_conversion<typename Container::key_type>(stream)
+                || needs_conversion<typename Container::mapped_type>(stream);
+        }
+        else
+        {
+            return needs_conversion<typename Container::key_type>(stream);
+        }
+    }
+
+    /**
+     * @brief Size in bytes of the file representation of an element of a set or a
+     * map whose elements satisfy @a has_bitwise_entries_v .
+     * 
+     * @tparam Container an associative container.
+     */
+    template <class Container>
+    inline constexpr size_t bitwise_entry_size_v = []
+    {
+        if constexpr (requires { typename Container::mapped_type; })
+        {
+            return sizeof(typename Container::key_type) + sizeof(typename Container::mapped_type);
+        }
+        else
+        {
+            return sizeof(typename Container::key_type);
+        }
+    }();
+
+    /**
+     * @brief Largest alignment accepted by @a write_aligned_to_file .
+     */
+    inline constexpr size_t FILE_OPERATIONS_MAX_ALIGNMENT = 4096;
+
+    // Writing operations.
+    template <class Stream>
+    void inline write_to_file(const signed char& val, Stream&& stream)
     {
-        fread(&val, sizeof(char), 1, file);
+        write_bytes(stream, &val, sizeof(signed char));
     }
 
-    void inline read_from_file(signed char& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const char& val, Stream&& stream)
     {
-        fread(&val, sizeof(signed char), 1, file);
+        write_bytes(stream, &val, sizeof(char));
     }
 
-    void inline read_from_file(unsigned char& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const unsigned char& val, Stream&& stream)
     {
-        fread(&val, sizeof(unsigned char), 1, file);
+        write_bytes(stream, &val, sizeof(unsigned char));
     }
 
-    void inline read_from_file(short int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const short int& val, Stream&& stream)
     {
-        fread(&val, sizeof(short int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(unsigned short int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const unsigned short int& val, Stream&& stream)
     {
-        fread(&val, sizeof(unsigned short int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const int& val, Stream&& stream)
     {
-        fread(&val, sizeof(int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(unsigned int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const unsigned int& val, Stream&& stream)
     {
-        fread(&val, sizeof(unsigned int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(long int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const long int& val, Stream&& stream)
     {
-        fread(&val, sizeof(long int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(unsigned long int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const unsigned long int& val, Stream&& stream)
     {
-        fread(&val, sizeof(unsigned long int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(long long int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const long long int& val, Stream&& stream)
     {
-        fread(&val, sizeof(long long int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(unsigned long long int& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const unsigned long long int& val, Stream&& stream)
     {
-        fread(&val, sizeof(unsigned long long int), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(float& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const float& val, Stream&& stream)
     {
-        fread(&val, sizeof(float), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(double& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const double& val, Stream&& stream)
     {
-        fread(&val, sizeof(double), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(long double& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const long double& val, Stream&& stream)
     {
-        fread(&val, sizeof(long double), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(wchar_t& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const wchar_t& val, Stream&& stream)
     {
-        fread(&val, sizeof(wchar_t), 1, file);
+        write_array_to_file(&val, 1, stream);
     }
 
-    void inline read_from_file(bool& val, FILE* file)
+    template <class Stream>
+    void inline write_to_file(const bool& val, Stream&& stream)
     {
-        char temp;
-        read_from_file(temp, file);
-        val = temp;
+        write_to_file((char) val, stream);
     }
 
-    void inline read_from_file(std::string& val, FILE* file)
+    template <class Traits, class Allocator, class Stream>
+    void inline write_to_file(const std::basic_string<char, Traits, Allocator>& str, Stream&& stream)
     {
-        unsigned int N;
-        read_from_file(N, file);
-        char* str = new char[N];
-        for (unsigned int i = 0; i < N; i++)
-        {
-            fread(str + i, sizeof(char), 1, file);
-        }
-        val = std::string(str);
-        delete[] str;
+        write_size_to_file(str.size(), stream);
+        write_bytes(stream, str.c_str(), str.size()+1);
     }
 
-    template <class K>
-    void inline read_from_file(std::complex<K>& z, FILE* file)
+    template <class K, class Stream>
+    void inline write_to_file(const std::complex<K>& z, Stream&& stream)
     {
-        K x, y;
-        read_from_file(x, file);
-        read_from_file(y, file);
-        z = std::complex<K>(x, y);
+        write_to_file(z.real(), stream);
+        write_to_file(z.imag(), stream);
     }
 
-    template <class T, size_t N>
-    void inline read_from_file(std::array<T, N>& object, FILE* file)
+    template <class T, size_t N, class Stream>
+    void inline write_to_file(const std::array<T, N>& object, Stream&& stream)
     {
-        object = std::array<T, N>();
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            write_array_to_file(object.data(), N, stream);
+        }
+        else
         {
-            read_from_file(*it, file);
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                write_to_file(*it, stream);
+            }
         }
     }
 
-    template <class T>
-    void inline read_from_file(std::vector<T>& object, FILE* file)
+    template <class T, class Allocator, class Stream>
+    void inline write_to_file(const std::vector<T, Allocator>& object, Stream&& stream)
     {
-        unsigned int size;
-        read_from_file(size, file);
-        object = std::vector<T>(size);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        write_size_to_file(object.size(), stream);
+        if constexpr (has_encoding_tag_v<T>)
+        {
+            if (has_encoding_tags(stream))
+            {
+                write_encoded_elements(object, default_encoding<T>(stream), stream);
+                return;
+            }
+        }
+        if constexpr (is_char_string_v<T>)
+        {
+            if (has_batched_strings(stream))
+            {
+                write_strings_to_file(object, stream);
+                return;
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            write_array_to_file(object.data(), object.size(), stream);
+        }
+        else
         {
-            read_from_file(*it, file);
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                write_to_file(*it, stream);
+            }
         }
     }
 
-    template <class T>
-    void inline read_from_file(std::deque<T>& object, FILE* file)
+    template <class T, class Allocator, class Stream>
+    void inline write_to_file(const std::deque<T, Allocator>& object, Stream&& stream)
     {
-        unsigned int size;
-        read_from_file(size, file);
-        object = std::deque<T>(size);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        write_size_to_file(object.size(), stream);
+        if constexpr (has_encoding_tag_v<T>)
         {
-            read_from_file(*it, file);
+            if (has_encoding_tags(stream))
+            {
+                write_encoded_elements(object, default_encoding<T>(stream), stream);
+                return;
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            for_each_block(object, [&](const T* data, const size_t N)
+            {
+                write_array_to_file(data, N, stream);
+            });
+        }
+        else
+        {
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                write_to_file(*it, stream);
+            }
         }
     }
 
-    template <class T>
-    void inline read_from_file(std::forward_list<T>& object, FILE* file)
+    template <class T, class Allocator, class Stream>
+    void inline write_to_file(const std::forward_list<T, Allocator>& object, Stream&& stream)
     {
-        unsigned int size;
-        read_from_file(size, file);
-        object = std::forward_list<T>(size);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        write_size_to_file(std::distance(object.begin(), object.end()), stream);
+        for (auto it = object.begin(); it != object.end(); ++it)
         {
-            read_from_file(*it, file);
+            write_to_file(*it, stream);
         }
     }
 
-    template <class T>
-    void inline read_from_file(std::list<T>& object, FILE* file)
+    template <class T, class Allocator, class Stream>
+    void inline write_to_file(const std::list<T, Allocator>& object, Stream&& stream)
     {
-        unsigned int size;
-        read_from_file(size, file);
-        object = std::list<T>(size);
-        for (auto it = object.begin() + 1; it != object.end(); ++it)
+        write_size_to_file(object.size(), stream);
+        for (auto it = object.begin(); it != object.end(); ++it)
         {
-            read_from_file(*it, file);
+            write_to_file(*it, stream);
         }
     }
 
-    template <class T>
-    void inline read_from_file(T& object, FILE* file)
+    /**
+     * @brief Writes the size of a set or a map followed by its elements, in the
+     * order in which the container iterates over them. The elements of maps are
+     * written as their key followed by their value.
+     * 
+     * Elements made of bitwise serializable objects are gathered in a staging
+     * buffer, so that the stream receives a few large writes, unless they must
+     * be converted for the stream.
+     * 
+     * @tparam Container an associative container.
+     * @param object 
+     * @param stream 
+     */
+    template <class Container, class Stream>
+    void inline write_associative_to_file(const Container& object, Stream&& stream)
+    {
+        constexpr bool IS_MAP = requires { typename Container::mapped_type; };
+        write_size_to_file(object.size(), stream);
+        if constexpr (has_bitwise_entries_v<Container>)
+        {
+            if (!entries_need_conversion<Container>(stream))
+            {
+                if (object.empty())
+                {
+                    return;
+                }
+                constexpr size_t ENTRY = bitwise_entry_size_v<Container>;
+                const size_t chunk = std::min(object.size(), std::max<size_t>(1, FILE_OPERATIONS_CHUNK_SIZE / ENTRY));
+                std::unique_ptr<std::byte[]> buffer(new std::byte[chunk * ENTRY]);
+                std::byte* next = buffer.get();
+                for (const auto& element : object)
+                {
+                    if constexpr (IS_MAP)
+                    {
+                        std::memcpy(next, &element.first, sizeof(element.first));
+                        std::memcpy(next + sizeof(element.first), &element.second, sizeof(element.second));
+                    }
+                    else
+                    {
+                        std::memcpy(next, &element, sizeof(element));
+                    }
+                    next += ENTRY;
+                    if (next == buffer.get() + chunk * ENTRY)
+                    {
+                        write_bytes(stream, buffer.get(), chunk * ENTRY);
+                        next = buffer.get();
+                    }
+                }
+                if (next != buffer.get())
+                {
+                    write_bytes(stream, buffer.get(), next - buffer.get());
+                }
+                return;
+            }
+        }
+        for (const auto& element : object)
+        {
+            if constexpr (IS_MAP)
+            {
+                write_to_file(element.first, stream);
+                write_to_file(element.second, stream);
+            }
+            else
+            {
+                write_to_file(element, stream);
+            }
+        }
+    }
+
+    template <class K, class V, class Stream>
+    void inline write_to_file(const std::pair<K, V>& object, Stream&& stream)
+    {
+        write_to_file(object.first, stream);
+        write_to_file(object.second, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    void inline write_to_file(const std::set<K, Compare, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    void inline write_to_file(const std::multiset<K, Compare, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void inline write_to_file(const std::map<K, V, Compare, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void inline write_to_file(const std::multimap<K, V, Compare, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline write_to_file(const std::unordered_set<K, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline write_to_file(const std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, Stream&& stream)
     {
-        object.read_from_file(file);
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline write_to_file(const std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline write_to_file(const std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        write_associative_to_file(object, stream);
+    }
+
+    template <class Container, class Stream>
+    void inline write_to_file(const EncodedContainer<Container>& object, Stream&& stream)
+    {
+        static_assert(has_encoding_tag_v<typename Container::value_type>,
+            "Only containers of numbers can be encoded.");
+        if (!has_encoding_tags(stream))
+        {
+            throw std::invalid_argument("write_to_file: encodings require an archive of version 2 or later.");
+        }
+        write_size_to_file(object.container.size(), stream);
+        write_encoded_elements(object.container, object.encoding, stream);
+    }
+
+    template <class T, class Stream>
+    void inline write_to_file(const T& object, Stream&& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            write_array_to_file(&object, 1, stream);
+        }
+        else
+        {
+            object.write_to_file(stream);
+        }
+    }
+
+    /**
+     * @brief Writes a vector so that its elements start at a multiple of
+     * @a alignment bytes from the beginning of the file.
+     * 
+     * The layout is the size of the vector, the number of padding bytes as an
+     * unsigned short, the padding and the elements. The elements can therefore be
+     * used in place from a memory mapping of the file (for example, by SIMD code).
+     * Vectors saved this way must be read with @a read_aligned_from_file .
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param object 
+     * @param stream a stream whose position is known (see @a stream_position ).
+     * @param alignment a power of two not greater than FILE_OPERATIONS_MAX_ALIGNMENT.
+     */
+    template <class T, class Stream>
+    void inline write_aligned_to_file(const std::vector<T>& object, Stream&& stream,
+        const size_t alignment = 64)
+    {
+        static_assert(is_bitwise_serializable_v<T>,
+            "write_aligned_to_file requires a bitwise serializable type.");
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0
+            || alignment > FILE_OPERATIONS_MAX_ALIGNMENT)
+        {
+            throw std::invalid_argument("write_aligned_to_file: invalid alignment.");
+        }
+        write_size_to_file(object.size(), stream);
+        const long position = stream_position(stream);
+        if (position < 0)
+        {
+            throw std::runtime_error("write_aligned_to_file: the position of the stream is unknown.");
+        }
+        const size_t payload = position + sizeof(unsigned short);
+        const unsigned short padding = (alignment - payload % alignment) % alignment;
+        write_to_file(padding, stream);
+        static const char zeros[FILE_OPERATIONS_MAX_ALIGNMENT] = {};
+        write_array_to_file(zeros, padding, stream);
+        write_array_to_file(object.data(), object.size(), stream);
+    }
+
+
+    // Sizes of the file representation.
+
+    /**
+     * @brief Sink that discards everything written to it and counts the bytes,
+     * with the format and the encoding of integers of the stream it stands for.
+     * It measures objects that have no cheaper way of computing their size.
+     * 
+     */
+    class MeasuringSink
+    {
+    public:
+        explicit MeasuringSink(const FileFormat& format = LEGACY_FILE_FORMAT,
+            const Encoding integer_encoding = Encoding::RAW)
+            : format_(format), integer_encoding_(integer_encoding), count_(0) {}
+
+        void write(const void*, const size_t bytes) { count_ += bytes; }
+        void flush() {}
+        size_t tell() const { return count_; }
+        void patch(const size_t, const void*, const size_t) {}
+
+        const FileFormat& format() const { return format_; }
+        Encoding integer_encoding() const { return integer_encoding_; }
+
+    private:
+        FileFormat format_;
+        Encoding integer_encoding_;
+        size_t count_;
+    };
+
+    /**
+     * @brief Returns the size in bytes of the size of a container or a string.
+     * 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Stream>
+    size_t inline serialized_size_width(const Stream& stream)
+    {
+        return stream_format(stream).size_width == 8 ? 8 : 4;
+    }
+
+    /**
+     * @brief Returns the number of bytes written by @a write_encoded_elements ,
+     * which requires encoding the elements if the encoding is not RAW.
+     * 
+     * @tparam Container 
+     * @param object 
+     * @param encoding 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Container, class Stream>
+    size_t inline serialized_encoded_size(const Container& object, const Encoding encoding, const Stream& stream)
+    {
+        using T = typename Container::value_type;
+        if (!is_valid_encoding<T>(encoding))
+        {
+            throw std::invalid_argument("serialized_size: invalid encoding for this type.");
+        }
+        if (encoding == Encoding::RAW)
+        {
+            return 1 + object.size() * serialized_element_size<T>(stream);
+        }
+        std::uint64_t bytes;
+        if constexpr (std::is_integral_v<T>)
+        {
+            VarintEncoder<T> measurer(encoding == Encoding::DELTA_VARINT);
+            for_each_block(object, [&](const T* data, const size_t N) { measurer.measure(data, N); });
+            bytes = measurer.measured_bytes();
+        }
+        else
+        {
+            XorEncoder<T> measurer;
+            for_each_block(object, [&](const T* data, const size_t N) { measurer.measure(data, N); });
+            bytes = measurer.measured_bytes();
+        }
+        return 1 + sizeof(std::uint64_t) + bytes;
+    }
+
+    /**
+     * @brief Returns the number of bytes that write_to_file(object, stream) writes,
+     * without writing anything. The stream only provides the format and the
+     * encoding of integers, so it can be the sink the object will be written
+     * to, a @a MeasuringSink standing for it or just a @a FileFormat . The header
+     * of archives (FILE_HEADER_SIZE bytes, see Archive.hpp) is not included:
+     * 
+     * const size_t bytes = FILE_HEADER_SIZE + serialized_size(state, FileFormat());
+     * 
+     * The size of containers of bitwise serializable objects is computed in
+     * constant time, and that of vectors of strings from the sizes of the strings.
+     * Containers of numbers with a compact encoding (see Encodings.hpp) are encoded
+     * to be measured. Objects that implement write_to_file can implement the public
+     * method serialized_size(const Stream& stream) too; otherwise, they are written
+     * to a @a MeasuringSink .
+     * 
+     * Vectors written with @a write_aligned_to_file take up to alignment - 1 bytes
+     * more than the result for the vector.
+     * 
+     * @tparam T 
+     * @param object 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Stream>
+    size_t inline serialized_size(const bool&, const Stream&)
+    {
+        return sizeof(char);
+    }
+
+    template <class Traits, class Allocator, class Stream>
+    size_t inline serialized_size(const std::basic_string<char, Traits, Allocator>& str, const Stream& stream)
+    {
+        return serialized_size_width(stream) + str.size() + 1;
+    }
+
+    template <class K, class Stream>
+    size_t inline serialized_size(const std::complex<K>& z, const Stream& stream)
+    {
+        return serialized_size(z.real(), stream) + serialized_size(z.imag(), stream);
+    }
+
+    /**
+     * @brief Returns the sum of the sizes in bytes of the elements of a range.
+     * 
+     * @tparam Container 
+     * @param object 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Container, class Stream>
+    size_t inline serialized_elements_size(const Container& object, const Stream& stream)
+    {
+        size_t bytes = 0;
+        for (const auto& element : object)
+        {
+            bytes += serialized_size(element, stream);
+        }
+        return bytes;
+    }
+
+    template <class T, size_t N, class Stream>
+    size_t inline serialized_size(const std::array<T, N>& object, const Stream& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            return N * serialized_element_size<T>(stream);
+        }
+        else
+        {
+            return serialized_elements_size(object, stream);
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    size_t inline serialized_size(const std::vector<T, Allocator>& object, const Stream& stream)
+    {
+        const size_t width = serialized_size_width(stream);
+        if constexpr (has_encoding_tag_v<T>)
+        {
+            if (has_encoding_tags(stream))
+            {
+                return width + serialized_encoded_size(object, default_encoding<T>(stream), stream);
+            }
+        }
+        if constexpr (is_char_string_v<T>)
+        {
+            if (has_batched_strings(stream))
+            {
+                size_t bytes = width + object.size() * width;
+                for (size_t i = 0; i < object.size(); i = string_block_end(object, i, width))
+                {
+                    bytes += width;
+                }
+                for (const T& str : object)
+                {
+                    bytes += str.size();
+                }
+                return bytes;
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            return width + object.size() * serialized_element_size<T>(stream);
+        }
+        else
+        {
+            return width + serialized_elements_size(object, stream);
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    size_t inline serialized_size(const std::deque<T, Allocator>& object, const Stream& stream)
+    {
+        const size_t width = serialized_size_width(stream);
+        if constexpr (has_encoding_tag_v<T>)
+        {
+            if (has_encoding_tags(stream))
+            {
+                return width + serialized_encoded_size(object, default_encoding<T>(stream), stream);
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            return width + object.size() * serialized_element_size<T>(stream);
+        }
+        else
+        {
+            return width + serialized_elements_size(object, stream);
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    size_t inline serialized_size(const std::forward_list<T, Allocator>& object, const Stream& stream)
+    {
+        return serialized_size_width(stream) + serialized_elements_size(object, stream);
+    }
+
+    template <class T, class Allocator, class Stream>
+    size_t inline serialized_size(const std::list<T, Allocator>& object, const Stream& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            return serialized_size_width(stream) + object.size() * serialized_element_size<T>(stream);
+        }
+        else
+        {
+            return serialized_size_width(stream) + serialized_elements_size(object, stream);
+        }
+    }
+
+    /**
+     * @brief Returns the number of bytes written by @a write_associative_to_file .
+     * 
+     * @tparam Container an associative container.
+     * @param object 
+     * @param stream 
+     * @return size_t 
+     */
+    template <class Container, class Stream>
+    size_t inline serialized_associative_size(const Container& object, const Stream& stream)
+    {
+        const size_t width = serialized_size_width(stream);
+        if constexpr (has_bitwise_entries_v<Container>)
+        {
+            if constexpr (requires { typename Container::mapped_type; })
+            {
+                return width + object.size() * (serialized_element_size<typename Container::key_type>(stream)
+                    + serialized_element_size<typename Container::mapped_type>(stream));
+            }
+            else
+            {
+                return width + object.size() * serialized_element_size<typename Container::key_type>(stream);
+            }
+        }
+        else
+        {
+            size_t bytes = width;
+            for (const auto& element : object)
+            {
+                if constexpr (requires { typename Container::mapped_type; })
+                {
+                    bytes += serialized_size(element.first, stream) + serialized_size(element.second, stream);
+                }
+                else
+                {
+                    bytes += serialized_size(element, stream);
+                }
+            }
+            return bytes;
+        }
+    }
+
+    template <class K, class V, class Stream>
+    size_t inline serialized_size(const std::pair<K, V>& object, const Stream& stream)
+    {
+        return serialized_size(object.first, stream) + serialized_size(object.second, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    size_t inline serialized_size(const std::set<K, Compare, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    size_t inline serialized_size(const std::multiset<K, Compare, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    size_t inline serialized_size(const std::map<K, V, Compare, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    size_t inline serialized_size(const std::multimap<K, V, Compare, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t inline serialized_size(const std::unordered_set<K, Hash, KeyEqual, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t inline serialized_size(const std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t inline serialized_size(const std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    size_t inline serialized_size(const std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, const Stream& stream)
+    {
+        return serialized_associative_size(object, stream);
+    }
+
+    template <class Container, class Stream>
+    size_t inline serialized_size(const EncodedContainer<Container>& object, const Stream& stream)
+    {
+        if (!has_encoding_tags(stream))
+        {
+            throw std::invalid_argument("serialized_size: encodings require an archive of version 2 or later.");
+        }
+        return serialized_size_width(stream) + serialized_encoded_size(object.container, object.encoding, stream);
+    }
+
+    template <class T, class Stream>
+    size_t inline serialized_size(const T& object, const Stream& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            return serialized_element_size<T>(stream);
+        }
+        else if constexpr (requires { object.serialized_size(stream); })
+        {
+            return object.serialized_size(stream);
+        }
+        else
+        {
+            MeasuringSink sink(stream_format(stream), default_encoding<int>(stream));
+            object.write_to_file(sink);
+            return sink.tell();
+        }
+    }
+
+
+    // Reading operations.
+    template <class Stream>
+    void inline read_from_file(char& val, Stream&& stream)
+    {
+        read_bytes(stream, &val, sizeof(char));
+    }
+
+    template <class Stream>
+    void inline read_from_file(signed char& val, Stream&& stream)
+    {
+        read_bytes(stream, &val, sizeof(signed char));
+    }
+
+    template <class Stream>
+    void inline read_from_file(unsigned char& val, Stream&& stream)
+    {
+        read_bytes(stream, &val, sizeof(unsigned char));
+    }
+
+    template <class Stream>
+    void inline read_from_file(short int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(unsigned short int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(unsigned int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(long int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(unsigned long int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(long long int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(unsigned long long int& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(float& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(double& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(long double& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(wchar_t& val, Stream&& stream)
+    {
+        read_array_from_file(&val, 1, stream);
+    }
+
+    template <class Stream>
+    void inline read_from_file(bool& val, Stream&& stream)
+    {
+        char temp;
+        read_from_file(temp, stream);
+        val = temp;
+    }
+
+    template <class Traits, class Allocator, class Stream>
+    void inline read_from_file(std::basic_string<char, Traits, Allocator>& val, Stream&& stream)
+    {
+        // The string is resized once, so its capacity is reused, and read with a single call.
+        const size_t N = read_size_from_file(stream);
+        val.resize(N);
+        read_bytes(stream, val.data(), N);
+        char terminator;
+        read_bytes(stream, &terminator, 1);
+        if (terminator != '\0')
+        {
+            throw std::runtime_error("read_from_file: malformed string.");
+        }
+    }
+
+    template <class K, class Stream>
+    void inline read_from_file(std::complex<K>& z, Stream&& stream)
+    {
+        K x, y;
+        read_from_file(x, stream);
+        read_from_file(y, stream);
+        z = std::complex<K>(x, y);
+    }
+
+    template <class T, size_t N, class Stream>
+    void inline read_from_file(std::array<T, N>& object, Stream&& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            read_array_from_file(object.data(), N, stream);
+        }
+        else
+        {
+            object = std::array<T, N>();
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                read_from_file(*it, stream);
+            }
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    void inline read_from_file(std::vector<T, Allocator>& object, Stream&& stream)
+    {
+        const size_t size = read_size_from_file(stream);
+        if constexpr (has_encoding_tag_v<T>)
+        {
+            if (has_encoding_tags(stream))
+            {
+                read_encoded_elements(object, size, stream);
+                return;
+            }
+        }
+        if constexpr (is_char_string_v<T>)
+        {
+            if (has_batched_strings(stream))
+            {
+                read_strings_from_file(object, size, stream);
+                return;
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            read_array_from_file(object, size, stream);
+        }
+        else
+        {
+            object.clear();
+            object.resize(size);
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                read_from_file(*it, stream);
+            }
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    void inline read_from_file(std::deque<T, Allocator>& object, Stream&& stream)
+    {
+        const size_t size = read_size_from_file(stream);
+        if constexpr (has_encoding_tag_v<T>)
+        {
+            if (has_encoding_tags(stream))
+            {
+                read_encoded_elements(object, size, stream);
+                return;
+            }
+        }
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            object.clear();
+            append_array_from_file<T>(object, size, stream);
+        }
+        else
+        {
+            object.clear();
+            object.resize(size);
+            for (auto it = object.begin(); it != object.end(); ++it)
+            {
+                read_from_file(*it, stream);
+            }
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    void inline read_from_file(std::forward_list<T, Allocator>& object, Stream&& stream)
+    {
+        const size_t size = read_size_from_file(stream);
+        object.clear();
+        object.resize(size);
+        for (auto it = object.begin(); it != object.end(); ++it)
+        {
+            read_from_file(*it, stream);
+        }
+    }
+
+    template <class T, class Allocator, class Stream>
+    void inline read_from_file(std::list<T, Allocator>& object, Stream&& stream)
+    {
+        const size_t size = read_size_from_file(stream);
+        object.clear();
+        object.resize(size);
+        for (auto it = object.begin(); it != object.end(); ++it)
+        {
+            read_from_file(*it, stream);
+        }
+    }
+
+    /**
+     * @brief Replaces the contents of a set or a map with the elements written by
+     * @a write_associative_to_file .
+     * 
+     * Every element is inserted with a hint at the end of the container. Since ordered
+     * containers are written in order, each insertion takes constant time and the
+     * whole reconstruction is linear instead of O(N log N). Unordered containers
+     * reserve room for all the elements beforehand, so that they never rehash.
+     * 
+     * @tparam Container an associative container.
+     * @param object 
+     * @param stream 
+     */
+    template <class Container, class Stream>
+    void inline read_associative_from_file(Container& object, Stream&& stream)
+    {
+        using K = typename Container::key_type;
+        constexpr bool IS_MAP = requires { typename Container::mapped_type; };
+        size_t N = read_size_from_file(stream);
+        object.clear();
+        if constexpr (requires { object.reserve(N); })
+        {
+            object.reserve(N);
+        }
+        if constexpr (has_bitwise_entries_v<Container>)
+        {
+            if (!entries_need_conversion<Container>(stream))
+            {
+                if (N == 0)
+                {
+                    return;
+                }
+                constexpr size_t ENTRY = bitwise_entry_size_v<Container>;
+                const size_t chunk = std::min(N, std::max<size_t>(1, FILE_OPERATIONS_CHUNK_SIZE / ENTRY));
+                std::unique_ptr<std::byte[]> buffer(new std::byte[chunk * ENTRY]);
+                while (N > 0)
+                {
+                    const size_t n = std::min(N, chunk);
+                    read_bytes(stream, buffer.get(), n * ENTRY);
+                    const std::byte* next = buffer.get();
+                    for (size_t i = 0; i < n; i++, next += ENTRY)
+                    {
+                        K key;
+                        std::memcpy(&key, next, sizeof(K));
+                        if constexpr (IS_MAP)
+                        {
+                            typename Container::mapped_type value;
+                            std::memcpy(&value, next + sizeof(K), sizeof(value));
+                            object.emplace_hint(object.end(), key, value);
+                        }
+                        else
+                        {
+                            object.emplace_hint(object.end(), key);
+                        }
+                    }
+                    N -= n;
+                }
+                return;
+            }
+        }
+        for (; N > 0; N--)
+        {
+            // Keys that allocate memory take it from the allocator of the container.
+            K key = std::make_obj_using_allocator<K>(object.get_allocator());
+            read_from_file(key, stream);
+            if constexpr (IS_MAP)
+            {
+                // The value is read in place, so that it is never moved.
+                auto it = object.emplace_hint(object.end(), std::piecewise_construct,
+                    std::forward_as_tuple(std::move(key)), std::forward_as_tuple());
+                read_from_file(it->second, stream);
+            }
+            else
+            {
+                object.emplace_hint(object.end(), std::move(key));
+            }
+        }
+    }
+
+    template <class K, class V, class Stream>
+    void inline read_from_file(std::pair<K, V>& object, Stream&& stream)
+    {
+        read_from_file(object.first, stream);
+        read_from_file(object.second, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    void inline read_from_file(std::set<K, Compare, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class Compare, class Allocator, class Stream>
+    void inline read_from_file(std::multiset<K, Compare, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void inline read_from_file(std::map<K, V, Compare, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class V, class Compare, class Allocator, class Stream>
+    void inline read_from_file(std::multimap<K, V, Compare, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline read_from_file(std::unordered_set<K, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline read_from_file(std::unordered_multiset<K, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline read_from_file(std::unordered_map<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class K, class V, class Hash, class KeyEqual, class Allocator, class Stream>
+    void inline read_from_file(std::unordered_multimap<K, V, Hash, KeyEqual, Allocator>& object, Stream&& stream)
+    {
+        read_associative_from_file(object, stream);
+    }
+
+    template <class T, class Stream>
+    void inline read_from_file(T& object, Stream&& stream)
+    {
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            read_array_from_file(&object, 1, stream);
+        }
+        else
+        {
+            object.read_from_file(stream);
+        }
+    }
+
+    /**
+     * @brief Returns an object read from a stream that takes its memory from a
+     * memory resource, such as a std::pmr::monotonic_buffer_resource .
+     * 
+     * T is usually a std::pmr container. Its elements are built with its allocator,
+     * so nested std::pmr containers and strings take their memory from the same
+     * resource, and so do temporary keys of sets and maps.
+     * 
+     * @tparam T a type constructible from a std::pmr::polymorphic_allocator .
+     * @param stream 
+     * @param resource 
+     * @return T 
+     */
+    template <class T, class Stream>
+    T inline read_from_file(Stream&& stream, std::pmr::memory_resource* resource)
+    {
+        T object = std::make_obj_using_allocator<T>(std::pmr::polymorphic_allocator<>(resource));
+        read_from_file(object, stream);
+        return object;
+    }
+
+    /**
+     * @brief Reads a vector saved with @a write_aligned_to_file .
+     * Throws std::runtime_error if the padding is malformed.
+     * 
+     * @tparam T a bitwise serializable type.
+     * @param object 
+     * @param stream 
+     */
+    template <class T, class Stream>
+    void inline read_aligned_from_file(std::vector<T>& object, Stream&& stream)
+    {
+        static_assert(is_bitwise_serializable_v<T>,
+            "read_aligned_from_file requires a bitwise serializable type.");
+        const size_t size = read_size_from_file(stream);
+        unsigned short padding;
+        read_from_file(padding, stream);
+        if (padding >= FILE_OPERATIONS_MAX_ALIGNMENT)
+        {
+            throw std::runtime_error("read_aligned_from_file: invalid padding.");
+        }
+        skip_bytes(stream, padding);
+        read_array_from_file(object, size, stream);
     }
 }
 
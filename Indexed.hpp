@@ -0,0 +1,286 @@
+/** 
+ * @file Indexed.hpp
+ * @brief This file contains containers with an offset table, which allows
+ * reading any element without decoding the previous ones.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * write_to_file(indexed(container), stream) writes a container followed by the
+ * offsets of its elements. read_from_file(indexed(container), stream) reads it
+ * back as a whole, whereas an @a IndexedReader reads single elements or ranges
+ * of elements in O(1) seeks, from a FILE pointer or a @a MappedFileReader :
+ * 
+ * MappedFile file("records.bin");
+ * MappedFileReader reader(file);
+ * IndexedReader<std::string, MappedFileReader> records(reader);
+ * std::string record = records.get(123456);
+ * 
+ * The layout is:
+ * - The number of elements N, as any other size.
+ * - 64 bits: size in bytes of the elements, E.
+ * - The elements, as written by @a write_to_file .
+ * - N + 1 offsets (64 bits each) of the beginning of each element, relative to
+ * the first one. The last one is E.
+ * 
+ * Since E is written once all the elements have been written, the stream must
+ * be able to patch data (see Streams.hpp).
+ */
+
+#ifndef ALS_UTILITIES_INDEXED_HPP
+#define ALS_UTILITIES_INDEXED_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "FileOperations.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief A container written or read with an offset table (see @a indexed ).
+     * 
+     * @tparam Container
+     */
+    template <class Container>
+    struct IndexedContainer
+    {
+        Container& container;
+    };
+
+    /**
+     * @brief Returns an object that makes @a write_to_file and @a read_from_file
+     * write and read a container with an offset table.
+     * 
+     * @tparam Container a std::vector, std::deque or std::list.
+     * @param container
+     * @return IndexedContainer<Container>
+     */
+    template <class Container>
+    IndexedContainer<Container> inline indexed(Container& container)
+    {
+        return IndexedContainer<Container>{container};
+    }
+
+    /**
+     * @brief Sink that forwards everything to another sink and counts the bytes
+     * written, so that positions are known without asking the underlying sink.
+     * 
+     * @tparam Sink a FILE pointer or a sink.
+     */
+    template <class Sink>
+    class CountingSink
+    {
+    public:
+        explicit CountingSink(stream_reference_t<Sink> sink) : sink_(sink), count_(0) {}
+
+        void write(const void* data, const size_t bytes)
+        {
+            write_bytes(sink_, data, bytes);
+            count_ += bytes;
+        }
+
+        void flush() { flush_stream(sink_); }
+        size_t tell() const { return count_; }
+        FileFormat format() const { return stream_format(sink_); }
+
+        Encoding integer_encoding() const requires requires (const Sink& sink) { sink.integer_encoding(); }
+        {
+            return sink_.integer_encoding();
+        }
+
+    private:
+        stream_reference_t<Sink> sink_;
+        size_t count_;
+    };
+
+    template <class Container, class Stream>
+    void inline write_to_file(const IndexedContainer<Container>& object, Stream&& stream)
+    {
+        const size_t N = object.container.size();
+        write_size_to_file(N, stream);
+        const long start = stream_position(stream);
+        if (start < 0)
+        {
+            throw std::runtime_error("write_to_file: the position of the stream is unknown.");
+        }
+        std::uint64_t bytes = 0;
+        write_array_to_file(&bytes, 1, stream);
+
+        // Positions are counted by hand, as asking a FILE pointer costs a system call.
+        std::vector<std::uint64_t> offsets;
+        offsets.reserve(N + 1);
+        CountingSink<std::remove_reference_t<Stream>> counter(stream);
+        for (const auto& element : object.container)
+        {
+            offsets.push_back(counter.tell());
+            write_to_file(element, counter);
+        }
+        offsets.push_back(counter.tell());
+        write_array_to_file(offsets.data(), offsets.size(), stream);
+        bytes = has_swapped_byte_order(stream) ? byte_swap(offsets.back()) : offsets.back();
+        patch_bytes(stream, start, &bytes, sizeof(bytes));
+    }
+
+    template <class Container, class Stream>
+    size_t inline serialized_size(const IndexedContainer<Container>& object, const Stream& stream)
+    {
+        const size_t N = object.container.size();
+        return serialized_size_width(stream) + sizeof(std::uint64_t) + serialized_elements_size(object.container, stream)
+            + (N + 1) * sizeof(std::uint64_t);
+    }
+
+    template <class Container, class Stream>
+    void inline read_from_file(const IndexedContainer<Container>& object, Stream&& stream)
+    {
+        const size_t N = read_size_from_file(stream);
+        std::uint64_t bytes;
+        read_array_from_file(&bytes, 1, stream);
+        object.container.resize(N);
+        for (auto& element : object.container)
+        {
+            read_from_file(element, stream);
+        }
+        skip_bytes(stream, (N + 1) * sizeof(std::uint64_t));
+    }
+
+    /**
+     * @brief Reads single elements or ranges of elements of a container written
+     * with write_to_file(indexed(container), stream), without reading the rest.
+     * 
+     * The reader moves the stream around, so the position of the stream is
+     * unspecified until @a seek_end is called.
+     * 
+     * @tparam T type of the elements.
+     * @tparam Stream a FILE pointer or a source with the method seek, such as
+     * a @a MappedFileReader .
+     */
+    template <class T, class Stream = FILE*>
+    class IndexedReader
+    {
+    public:
+        /**
+         * @brief Construct a new Indexed Reader object for the container that
+         * starts at the current position of the stream.
+         * 
+         * @param stream
+         */
+        explicit IndexedReader(stream_reference_t<Stream> stream) : stream_(stream)
+        {
+            size_ = read_size_from_file(stream_);
+            std::uint64_t bytes;
+            read_array_from_file(&bytes, 1, stream_);
+            const long position = stream_position(stream_);
+            if (position < 0)
+            {
+                throw std::runtime_error("IndexedReader: the position of the stream is unknown.");
+            }
+            base_ = position;
+            table_ = base_ + bytes;
+        }
+
+        /**
+         * @brief Returns the number of elements.
+         * 
+         * @return size_t
+         */
+        size_t size() const { return size_; }
+
+        /**
+         * @brief Reads the i-th element. Throws std::out_of_range if there is no such element.
+         * 
+         * @param i
+         * @param element
+         */
+        void read(const size_t i, T& element)
+        {
+            read(i, std::span<T>(&element, 1));
+        }
+
+        /**
+         * @brief Returns the i-th element. Throws std::out_of_range if there is no such element.
+         * 
+         * @param i
+         * @return T
+         */
+        T get(const size_t i)
+        {
+            T element;
+            read(i, element);
+            return element;
+        }
+
+        /**
+         * @brief Reads consecutive elements, starting with the first-th one.
+         * Throws std::out_of_range if there are not enough elements.
+         * 
+         * @param first
+         * @param elements
+         */
+        void read(const size_t first, std::span<T> elements)
+        {
+            if (first > size_ || elements.size() > size_ - first)
+            {
+                throw std::out_of_range("IndexedReader: the elements do not exist.");
+            }
+            if (elements.empty())
+            {
+                return;
+            }
+            seek_stream(stream_, base_ + offset(first));
+            for (T& element : elements)
+            {
+                read_from_file(element, stream_);
+            }
+        }
+
+        /**
+         * @brief Returns the size in bytes of the i-th element.
+         * 
+         * @param i
+         * @return size_t
+         */
+        size_t element_size(const size_t i)
+        {
+            if (i >= size_)
+            {
+                throw std::out_of_range("IndexedReader: the element does not exist.");
+            }
+            std::uint64_t offsets[2];
+            seek_stream(stream_, table_ + i * sizeof(std::uint64_t));
+            read_array_from_file(offsets, 2, stream_);
+            return offsets[1] - offsets[0];
+        }
+
+        /**
+         * @brief Moves the stream to the end of the container.
+         * 
+         */
+        void seek_end()
+        {
+            seek_stream(stream_, table_ + (size_ + 1) * sizeof(std::uint64_t));
+        }
+
+    private:
+        std::uint64_t offset(const size_t i)
+        {
+            std::uint64_t offset;
+            seek_stream(stream_, table_ + i * sizeof(std::uint64_t));
+            read_array_from_file(&offset, 1, stream_);
+            return offset;
+        }
+
+        stream_reference_t<Stream> stream_;
+        size_t size_;
+        size_t base_;
+        size_t table_;
+    };
+}
+
+#endif // ALS_UTILITIES_INDEXED_HPP
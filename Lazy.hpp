@@ -0,0 +1,218 @@
+/** 
+ * @file Lazy.hpp
+ * @brief This file contains proxies that are read from a file only when they
+ * are first used.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A @a Lazy object holds an object of type T. It is written with
+ * @a write_to_file as the size in bytes of T (64 bits) followed by T, so
+ * that @a read_from_file can skip it in O(1): it only records where T is and
+ * reads it on the first call to @a Lazy::get . Large members that are seldom
+ * used can thus be declared lazy, and so can the elements of containers:
+ * 
+ * struct Dataset
+ * {
+ *     std::string name;
+ *     std::vector<Lazy<std::vector<double>>> columns;
+ *     ALS_UTILITIES_FILE_FIELDS(name, columns)
+ * };
+ * 
+ * MappedFile file("dataset.bin");
+ * MappedFileReader reader(file);
+ * Dataset dataset;
+ * read_from_file(dataset, reader);               // Reads no column.
+ * const auto& column = dataset.columns[3].get(); // Reads one column.
+ * 
+ * Objects are only read lazily from the source given by the second template
+ * parameter: a @a MappedFileReader (the default), which is copied into the
+ * proxy, or a FILE pointer, whose position is restored after reading. The
+ * MappedFile or the FILE pointer must outlive the proxy. With other sources,
+ * T is read at once.
+ */
+
+#ifndef ALS_UTILITIES_LAZY_HPP
+#define ALS_UTILITIES_LAZY_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "FileOperations.hpp"
+#include "MappedFile.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief An object of type T that is read from a source the first time it is used.
+     * 
+     * Reading it is not thread-safe, not even through @a get const: the first call
+     * must not be concurrent with any other.
+     * 
+     * @tparam T
+     * @tparam Source a @a MappedFileReader or a FILE pointer.
+     */
+    template <class T, class Source = MappedFileReader>
+    class Lazy
+    {
+    public:
+        Lazy() : value_(), loaded_(true), source_(), offset_(0), bytes_(0) {}
+
+        Lazy(T value) : value_(std::move(value)), loaded_(true), source_(), offset_(0), bytes_(0) {}
+
+        /**
+         * @brief Returns the object, reading it if it has not been read yet.
+         * Throws std::runtime_error if it is malformed.
+         * 
+         * @return const T&
+         */
+        const T& get() const
+        {
+            if (!loaded_)
+            {
+                load();
+            }
+            return value_;
+        }
+
+        T& get()
+        {
+            if (!loaded_)
+            {
+                load();
+            }
+            return value_;
+        }
+
+        /**
+         * @brief Checks whether the object is in memory.
+         * 
+         * @return true
+         * @return false
+         */
+        bool loaded() const { return loaded_; }
+
+        /**
+         * @brief Forgets where the object was read from, so that it can no longer
+         * be read from the source, and replaces it.
+         * 
+         * @param value
+         */
+        void set(T value)
+        {
+            value_ = std::move(value);
+            loaded_ = true;
+        }
+
+        /**
+         * @brief Records where the object is, so that it is read from there by
+         * @a get . Used by @a read_from_file .
+         * 
+         * @param source a source positioned at the object.
+         * @param bytes size in bytes of the object in the source.
+         */
+        void defer(stream_reference_t<Source> source, const size_t bytes)
+        {
+            const long position = stream_position(source);
+            if (position < 0)
+            {
+                throw std::runtime_error("Lazy: the position of the source is unknown.");
+            }
+            source_ = source;
+            offset_ = position;
+            bytes_ = bytes;
+            value_ = T();
+            loaded_ = false;
+        }
+
+    private:
+        using SourceStorage = std::conditional_t<std::is_pointer_v<Source>, Source, std::optional<Source>>;
+
+        void load() const
+        {
+            size_t read;
+            if constexpr (std::is_pointer_v<Source>)
+            {
+                // The file is shared, so its position is given back.
+                const long position = stream_position(source_);
+                try
+                {
+                    seek_stream(source_, offset_);
+                    read_from_file(value_, source_);
+                    read = stream_position(source_) - offset_;
+                }
+                catch (...)
+                {
+                    // The original error is more useful than a failure to seek back.
+                    fseek(source_, position, SEEK_SET);
+                    throw;
+                }
+                seek_stream(source_, position);
+            }
+            else
+            {
+                // A copy of the source is read, so the original one is left untouched.
+                Source source = *source_;
+                seek_stream(source, offset_);
+                read_from_file(value_, source);
+                read = stream_position(source) - offset_;
+            }
+            if (read != bytes_)
+            {
+                throw std::runtime_error("Lazy: malformed object.");
+            }
+            loaded_ = true;
+        }
+
+        mutable T value_;
+        mutable bool loaded_;
+        SourceStorage source_;
+        size_t offset_;
+        size_t bytes_;
+    };
+
+    template <class T, class Source>
+    struct is_bitwise_serializable<Lazy<T, Source>> : std::false_type {};
+
+    template <class T, class Source, class Stream>
+    void inline write_to_file(const Lazy<T, Source>& object, Stream&& stream)
+    {
+        const T& value = object.get();
+        const std::uint64_t bytes = serialized_size(value, stream);
+        write_array_to_file(&bytes, 1, stream);
+        write_to_file(value, stream);
+    }
+
+    template <class T, class Source, class Stream>
+    void inline read_from_file(Lazy<T, Source>& object, Stream&& stream)
+    {
+        std::uint64_t bytes;
+        read_array_from_file(&bytes, 1, stream);
+        if constexpr (std::is_same_v<std::remove_cvref_t<Stream>, Source>)
+        {
+            object.defer(stream, bytes);
+            skip_bytes(stream, bytes);
+        }
+        else
+        {
+            T value;
+            read_from_file(value, stream);
+            object.set(std::move(value));
+        }
+    }
+
+    template <class T, class Source, class Stream>
+    size_t inline serialized_size(const Lazy<T, Source>& object, const Stream& stream)
+    {
+        return sizeof(std::uint64_t) + serialized_size(object.get(), stream);
+    }
+}
+
+#endif // ALS_UTILITIES_LAZY_HPP
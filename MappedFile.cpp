@@ -0,0 +1,76 @@
+#ifndef ALS_UTILITIES_MAPPED_FILE_CPP
+#define ALS_UTILITIES_MAPPED_FILE_CPP
+
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "MappedFile: cannot open " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "MappedFile: cannot stat " + path);
+    }
+
+    // mmap does not accept empty mappings, so empty files are just left unmapped.
+    size_ = info.st_size;
+    if (size_ > 0)
+    {
+        void* address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "MappedFile: cannot map " + path);
+        }
+        data_ = static_cast<std::byte*>(address);
+    }
+    close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (data_ != nullptr)
+        {
+            munmap(data_, size_);
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+    }
+}
+
+#endif // ALS_UTILITIES_MAPPED_FILE_CPP
@@ -0,0 +1,285 @@
+/** 
+ * @file MappedFile.hpp
+ * @brief This file contains a read-only memory mapping of files written
+ * with the functions of FileOperations.hpp.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A @a MappedFile maps a whole file into memory. A @a MappedFileReader walks
+ * through the mapping following the layout of @a write_to_file and returns
+ * views (std::span, std::string_view) that point straight into the mapping,
+ * so no data is copied and several processes share the same page cache.
+ * 
+ * If the file starts with the header of an archive (see Archive.hpp), the
+ * reader follows its format; otherwise, it follows @a LEGACY_FILE_FORMAT .
+ * 
+ * A @a MappedFileReader is also a source (see Streams.hpp), so @a read_from_file
+ * can read copies of any object from it.
+ * 
+ * Views of objects whose alignment is greater than one require their first
+ * element to be suitably aligned in the file. Vectors saved with
+ * @a write_aligned_to_file always are; other layouts may not be, in which case
+ * an exception is thrown. Views are not available either when the numbers of the
+ * archive must be converted on this machine (see Archive.hpp).
+ */
+
+#ifndef ALS_UTILITIES_MAPPED_FILE_HPP
+#define ALS_UTILITIES_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <span>
+
+#include "Archive.hpp"
+#include "FileOperations.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     * 
+     */
+    class MappedFile
+    {
+    public:
+        /**
+         * @brief Maps the file at the given path. Throws std::system_error on failure.
+         * 
+         * @param path 
+         */
+        explicit MappedFile(const std::string& path);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        /**
+         * @brief Returns a pointer to the first byte of the file.
+         * 
+         * @return const std::byte* 
+         */
+        const std::byte* data() const { return data_; }
+
+        /**
+         * @brief Returns the size of the file in bytes.
+         * 
+         * @return size_t 
+         */
+        size_t size() const { return size_; }
+
+    private:
+        std::byte* data_;
+        size_t size_;
+    };
+
+    /**
+     * @brief Sequential reader over a MappedFile that follows the layout
+     * of @a write_to_file .
+     * 
+     * The returned views remain valid as long as the MappedFile is alive.
+     */
+    class MappedFileReader
+    {
+    public:
+        /**
+         * @brief Construct a new Mapped File Reader object.
+         * 
+         * @param file 
+         * @param offset position in bytes where reading starts. If the file has
+         * a header and the offset is zero, reading starts right after the header.
+         */
+        explicit MappedFileReader(const MappedFile& file, const size_t offset = 0)
+            : data_(file.data()), size_(file.size()), position_(offset), format_(LEGACY_FILE_FORMAT)
+        {
+            check(0);
+            if (has_file_header(data_, size_))
+            {
+                format_ = decode_file_header(data_);
+                position_ = std::max(position_, FILE_HEADER_SIZE);
+            }
+        }
+
+        /**
+         * @brief Returns the format of the file.
+         * 
+         * @return const FileFormat& 
+         */
+        const FileFormat& format() const { return format_; }
+
+        /**
+         * @brief Returns the current position in bytes.
+         * 
+         * @return size_t 
+         */
+        size_t tell() const { return position_; }
+
+        /**
+         * @brief Moves to the given position in bytes.
+         * 
+         * @param offset 
+         */
+        void seek(const size_t offset)
+        {
+            position_ = offset;
+            check(0);
+        }
+
+        /**
+         * @brief Skips the given number of bytes.
+         * 
+         * @param bytes 
+         */
+        void skip(const size_t bytes)
+        {
+            check(bytes);
+            position_ += bytes;
+        }
+
+        /**
+         * @brief Copies the given number of bytes.
+         * 
+         * @param data 
+         * @param bytes 
+         */
+        void read(void* data, const size_t bytes)
+        {
+            check(bytes);
+            std::memcpy(data, data_ + position_, bytes);
+            position_ += bytes;
+        }
+
+        /**
+         * @brief Reads a copy of an object saved with @a write_to_file .
+         * 
+         * @tparam T a bitwise serializable type.
+         * @return T 
+         */
+        template <class T>
+        T read()
+        {
+            static_assert(is_bitwise_serializable_v<T>,
+                "MappedFileReader::read requires a bitwise serializable type.");
+            T object;
+            read_array_from_file(&object, 1, *this);
+            return object;
+        }
+
+        /**
+         * @brief Returns a view of a std::array saved with @a write_to_file .
+         * 
+         * @tparam T a bitwise serializable type.
+         * @tparam N 
+         * @return std::span<const T, N> 
+         */
+        template <class T, size_t N>
+        std::span<const T, N> read_array_span()
+        {
+            return std::span<const T, N>(view<T>(N), N);
+        }
+
+        /**
+         * @brief Returns a view of a std::vector saved with @a write_to_file .
+         * Throws std::runtime_error if its elements are encoded (see Encodings.hpp);
+         * such vectors must be read with @a read_from_file .
+         * 
+         * @tparam T a bitwise serializable type.
+         * @return std::span<const T> 
+         */
+        template <class T>
+        std::span<const T> read_span()
+        {
+            const size_t N = read_size_from_file(*this);
+            if constexpr (has_encoding_tag_v<T>)
+            {
+                if (has_encoding_tags(*this) && read<Encoding>() != Encoding::RAW)
+                {
+                    throw std::runtime_error("MappedFileReader: the vector is encoded.");
+                }
+            }
+            return std::span<const T>(view<T>(N), N);
+        }
+
+        /**
+         * @brief Returns a view of a std::vector saved with @a write_aligned_to_file .
+         * 
+         * @tparam T a bitwise serializable type.
+         * @return std::span<const T> 
+         */
+        template <class T>
+        std::span<const T> read_aligned_span()
+        {
+            const size_t N = read_size_from_file(*this);
+            skip(read<unsigned short>());
+            return std::span<const T>(view<T>(N), N);
+        }
+
+        /**
+         * @brief Returns a view of a std::string saved with @a write_to_file .
+         * Throws std::runtime_error if the string is not terminated.
+         * 
+         * @return std::string_view 
+         */
+        std::string_view read_string_view()
+        {
+            const size_t N = read_size_from_file(*this);
+            if (position_ > size_ || N >= size_ - position_)
+            {
+                throw std::out_of_range("MappedFileReader: read past the end of the file.");
+            }
+            const char* str = view<char>(N + 1);
+            if (str[N] != '\0')
+            {
+                throw std::runtime_error("MappedFileReader: malformed string.");
+            }
+            return std::string_view(str, N);
+        }
+
+    private:
+        void check(const size_t bytes) const
+        {
+            if (position_ > size_ || bytes > size_ - position_)
+            {
+                throw std::out_of_range("MappedFileReader: read past the end of the file.");
+            }
+        }
+
+        template <class T>
+        const T* view(const size_t N)
+        {
+            static_assert(is_bitwise_serializable_v<T>,
+                "MappedFileReader views require a bitwise serializable type.");
+            if (needs_conversion<T>(*this))
+            {
+                throw std::runtime_error("MappedFileReader: the data must be converted; "
+                    "read it with read_from_file.");
+            }
+            if (N > (size_ - position_) / sizeof(T))
+            {
+                throw std::out_of_range("MappedFileReader: read past the end of the file.");
+            }
+            const std::byte* first = data_ + position_;
+            if (reinterpret_cast<uintptr_t>(first) % alignof(T) != 0)
+            {
+                throw std::runtime_error("MappedFileReader: the data is not suitably aligned.");
+            }
+            position_ += N * sizeof(T);
+            return reinterpret_cast<const T*>(first);
+        }
+
+        const std::byte* data_;
+        size_t size_;
+        size_t position_;
+        FileFormat format_;
+    };
+}
+
+#endif // ALS_UTILITIES_MAPPED_FILE_HPP
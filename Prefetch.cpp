@@ -0,0 +1,296 @@
+#ifndef ALS_UTILITIES_PREFETCH_CPP
+#define ALS_UTILITIES_PREFETCH_CPP
+
+#include "Prefetch.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+namespace
+{
+    int open_or_throw(const std::string& path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "PrefetchSource: cannot open " + path);
+        }
+        return fd;
+    }
+
+    size_t start_offset(const int fd, const long long offset)
+    {
+        if (offset >= 0)
+        {
+            return offset;
+        }
+        const off_t position = lseek(fd, 0, SEEK_CUR);
+        if (position < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "PrefetchSource: the file is not seekable");
+        }
+        return position;
+    }
+
+    // Reads until the buffer is full or the file ends.
+    size_t read_at(const int fd, std::byte* data, const size_t bytes, const size_t offset)
+    {
+        size_t read = 0;
+        while (read < bytes)
+        {
+            const ssize_t n = pread(fd, data + read, bytes - read, offset + read);
+            if (n > 0)
+            {
+                read += n;
+                continue;
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            if (errno != EINTR)
+            {
+                throw std::system_error(errno, std::generic_category(), "PrefetchSource: read failed");
+            }
+        }
+        return read;
+    }
+}
+
+PrefetchSource::PrefetchSource(const int fd, const size_t buffer_size, const size_t buffers, const long long offset)
+    : PrefetchSource(fd, buffer_size, buffers, offset, false)
+{
+}
+
+PrefetchSource::PrefetchSource(const std::string& path, const size_t buffer_size, const size_t buffers)
+    : PrefetchSource(open_or_throw(path), buffer_size, buffers, 0, true)
+{
+}
+
+PrefetchSource::PrefetchSource(const int fd, const size_t buffer_size, const size_t buffers, const long long offset,
+    const bool owns_fd)
+    : fd_(fd), owns_fd_(owns_fd), capacity_(std::max<size_t>(buffer_size, 1)), count_(buffers),
+    holding_(false), offset_(0), begin_(0), end_(0),
+    head_(0), filled_(0), next_offset_(0), generation_(0), finished_(false), stopping_(false)
+{
+    try
+    {
+        if (count_ == 0)
+        {
+            throw std::invalid_argument("PrefetchSource: there must be at least one buffer.");
+        }
+        offset_ = start_offset(fd_, offset);
+        next_offset_ = offset_;
+        buffers_.resize(count_);
+        for (auto& buffer : buffers_)
+        {
+            buffer.reset(new std::byte[capacity_]);
+        }
+        sizes_.resize(count_);
+        offsets_.resize(count_);
+
+        // Hints only, so errors are ignored.
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fd_, offset_, count_ * capacity_, POSIX_FADV_WILLNEED);
+        thread_ = std::thread(&PrefetchSource::run, this);
+    }
+    catch (...)
+    {
+        // The destructor does not run, so the file would be left open.
+        if (owns_fd_)
+        {
+            close(fd_);
+        }
+        throw;
+    }
+}
+
+PrefetchSource::~PrefetchSource()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    space_.notify_one();
+    thread_.join();
+    if (owns_fd_)
+    {
+        close(fd_);
+    }
+}
+
+void PrefetchSource::read(void* data, size_t bytes)
+{
+    std::byte* destination = static_cast<std::byte*>(data);
+    while (bytes > 0)
+    {
+        if (begin_ == end_)
+        {
+            next_buffer(true);
+        }
+        const size_t n = std::min(bytes, end_ - begin_);
+        std::memcpy(destination, buffers_[head_].get() + begin_, n);
+        begin_ += n;
+        destination += n;
+        bytes -= n;
+    }
+}
+
+void PrefetchSource::skip(const size_t bytes)
+{
+    // Buffers that are already in memory are skipped; if the target is beyond
+    // them, the reader starts over there.
+    const size_t target = tell() + bytes;
+    while (target > offset_ + end_)
+    {
+        if (!next_buffer(false))
+        {
+            restart(target);
+            return;
+        }
+    }
+    begin_ = target - offset_;
+}
+
+void PrefetchSource::seek(const size_t offset)
+{
+    if (holding_ && offset >= offset_ && offset <= offset_ + end_)
+    {
+        begin_ = offset - offset_;
+    }
+    else if (offset > tell())
+    {
+        skip(offset - tell());
+    }
+    else if (offset != tell())
+    {
+        restart(offset);
+    }
+}
+
+bool PrefetchSource::next_buffer(const bool wait)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (holding_)
+    {
+        // The buffer that has been consumed goes back to the thread.
+        head_ = (head_ + 1) % count_;
+        filled_--;
+        holding_ = false;
+        offset_ += end_;
+        begin_ = 0;
+        end_ = 0;
+        space_.notify_one();
+    }
+    if (wait)
+    {
+        ready_.wait(lock, [this] { return filled_ > 0 || finished_ || error_ != nullptr; });
+    }
+    if (filled_ == 0)
+    {
+        if (!wait)
+        {
+            return false;
+        }
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        throw EndOfData("PrefetchSource: unexpected end of data.");
+    }
+    holding_ = true;
+    offset_ = offsets_[head_];
+    begin_ = 0;
+    end_ = sizes_[head_];
+    return true;
+}
+
+void PrefetchSource::restart(const size_t offset)
+{
+    {
+        // A read in flight belongs to the previous generation and is dropped.
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+        head_ = 0;
+        filled_ = 0;
+        next_offset_ = offset;
+        finished_ = false;
+        error_ = nullptr;
+    }
+    space_.notify_one();
+    posix_fadvise(fd_, offset, count_ * capacity_, POSIX_FADV_WILLNEED);
+    holding_ = false;
+    offset_ = offset;
+    begin_ = 0;
+    end_ = 0;
+}
+
+void PrefetchSource::run()
+{
+    while (true)
+    {
+        size_t index;
+        size_t offset;
+        size_t generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_.wait(lock, [this] { return stopping_ || (filled_ < count_ && !finished_ && !error_); });
+            if (stopping_)
+            {
+                return;
+            }
+            index = (head_ + filled_) % count_;
+            offset = next_offset_;
+            generation = generation_;
+            next_offset_ += capacity_;
+        }
+
+        // The kernel is asked for the data after the buffers, so that it is on
+        // its way by the time a buffer is free for it.
+        posix_fadvise(fd_, offset + count_ * capacity_, capacity_, POSIX_FADV_WILLNEED);
+        size_t bytes = 0;
+        std::exception_ptr error;
+        try
+        {
+            bytes = read_at(fd_, buffers_[index].get(), capacity_, offset);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (generation != generation_)
+            {
+                continue;
+            }
+            if (error)
+            {
+                error_ = error;
+            }
+            else
+            {
+                if (bytes > 0)
+                {
+                    sizes_[index] = bytes;
+                    offsets_[index] = offset;
+                    filled_++;
+                }
+                finished_ = (bytes < capacity_);
+            }
+        }
+        ready_.notify_one();
+    }
+}
+
+#endif // ALS_UTILITIES_PREFETCH_CPP
@@ -0,0 +1,150 @@
+/** 
+ * @file Prefetch.hpp
+ * @brief This file contains a source that reads a file ahead of its consumer
+ * in a background thread.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * With a synchronous source, decoding the data and waiting for the disk never
+ * overlap. A @a PrefetchSource keeps several buffers in flight instead: a
+ * background thread fills them one after another with the data that follows,
+ * while the caller decodes the ones that are already in memory. The kernel is
+ * also told that the file is read sequentially and which ranges come next
+ * (posix_fadvise), so that its own read-ahead runs further ahead:
+ * 
+ * PrefetchSource file("checkpoint.bin");
+ * ArchiveSource archive(file);
+ * read_from_file(state, archive);
+ * 
+ * Skips and seeks within the buffers that have already been read are free;
+ * longer ones discard the buffers and restart the reader at the new position.
+ */
+
+#ifndef ALS_UTILITIES_PREFETCH_HPP
+#define ALS_UTILITIES_PREFETCH_HPP
+
+#include <cstddef>
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Default size in bytes of each buffer of a @a PrefetchSource .
+     */
+    inline constexpr size_t DEFAULT_PREFETCH_BUFFER_SIZE = 4 << 20;
+
+    /**
+     * @brief Default number of buffers of a @a PrefetchSource .
+     */
+    inline constexpr size_t DEFAULT_PREFETCH_BUFFERS = 4;
+
+    /**
+     * @brief Source that reads a regular file with a background thread, which
+     * keeps the buffers that follow the current one filled.
+     */
+    class PrefetchSource
+    {
+    public:
+        /**
+         * @brief Construct a new Prefetch Source object that reads from an open file
+         * descriptor, which is not closed by the source. The file is read with
+         * pread, so its position is left untouched.
+         * Throws std::invalid_argument if there are no buffers.
+         * 
+         * @param fd
+         * @param buffer_size size of each buffer in bytes.
+         * @param buffers number of buffers, including the one being consumed.
+         * @param offset position to start reading at. If negative, the current
+         * position of the file descriptor.
+         */
+        explicit PrefetchSource(const int fd, const size_t buffer_size = DEFAULT_PREFETCH_BUFFER_SIZE,
+            const size_t buffers = DEFAULT_PREFETCH_BUFFERS, const long long offset = -1);
+
+        /**
+         * @brief Construct a new Prefetch Source object that opens a file.
+         * Throws std::system_error on failure and std::invalid_argument if there
+         * are no buffers. The file is closed if the construction fails.
+         * 
+         * @param path
+         * @param buffer_size size of each buffer in bytes.
+         * @param buffers number of buffers, including the one being consumed.
+         */
+        explicit PrefetchSource(const std::string& path, const size_t buffer_size = DEFAULT_PREFETCH_BUFFER_SIZE,
+            const size_t buffers = DEFAULT_PREFETCH_BUFFERS);
+
+        PrefetchSource(const PrefetchSource&) = delete;
+        PrefetchSource& operator=(const PrefetchSource&) = delete;
+
+        /**
+         * @brief Stops the thread and closes the file if the source opened it.
+         * 
+         */
+        ~PrefetchSource();
+
+        void read(void* data, size_t bytes);
+        void skip(const size_t bytes);
+        size_t tell() const { return offset_ + begin_; }
+
+        /**
+         * @brief Moves the source to an absolute position of the file.
+         * 
+         * @param offset
+         */
+        void seek(const size_t offset);
+
+        /**
+         * @brief Returns the underlying file descriptor.
+         * 
+         * @return int
+         */
+        int fd() const { return fd_; }
+
+    private:
+        PrefetchSource(const int fd, const size_t buffer_size, const size_t buffers, const long long offset,
+            const bool owns_fd);
+
+        bool next_buffer(const bool wait);
+        void restart(const size_t offset);
+        void run();
+
+        int fd_;
+        bool owns_fd_;
+        size_t capacity_;
+        size_t count_;
+
+        // Buffer being consumed.
+        bool holding_;
+        size_t offset_;
+        size_t begin_;
+        size_t end_;
+
+        // Ring of buffers shared with the thread. The first filled_ buffers from
+        // head_ on are ready, including the one being consumed.
+        std::vector<std::unique_ptr<std::byte[]>> buffers_;
+        std::vector<size_t> sizes_;
+        std::vector<size_t> offsets_;
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::condition_variable space_;
+        size_t head_;
+        size_t filled_;
+        size_t next_offset_;
+        size_t generation_;
+        bool finished_;
+        bool stopping_;
+        std::exception_ptr error_;
+        std::thread thread_;
+    };
+}
+
+#endif // ALS_UTILITIES_PREFETCH_HPP
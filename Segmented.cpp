@@ -0,0 +1,159 @@
+#ifndef ALS_UTILITIES_SEGMENTED_CPP
+#define ALS_UTILITIES_SEGMENTED_CPP
+
+#include "Segmented.hpp"
+
+#include <cerrno>
+#include <exception>
+#include <mutex>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+// FileDescriptor.
+FileDescriptor::FileDescriptor(const std::string& path, const bool write)
+    : fd_(open(path.c_str(), (write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY) | O_CLOEXEC, 0644))
+{
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+}
+
+FileDescriptor::~FileDescriptor()
+{
+    close(fd_);
+}
+
+size_t FileDescriptor::size() const
+{
+    struct stat info;
+    if (fstat(fd_, &info) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "FileDescriptor: cannot stat the file");
+    }
+    return info.st_size;
+}
+
+void als::utilities::write_at(const int fd, const void* data, size_t bytes, size_t offset)
+{
+    const std::byte* source = static_cast<const std::byte*>(data);
+    while (bytes > 0)
+    {
+        const ssize_t written = pwrite(fd, source, bytes, offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write_at: write failed");
+        }
+        source += written;
+        offset += written;
+        bytes -= written;
+    }
+}
+
+void als::utilities::read_at(const int fd, void* data, size_t bytes, size_t offset)
+{
+    std::byte* destination = static_cast<std::byte*>(data);
+    while (bytes > 0)
+    {
+        const ssize_t n = pread(fd, destination, bytes, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "read_at: read failed");
+        }
+        if (n == 0)
+        {
+            throw std::runtime_error("read_at: unexpected end of data.");
+        }
+        destination += n;
+        offset += n;
+        bytes -= n;
+    }
+}
+
+size_t als::utilities::thread_count(const size_t threads)
+{
+    if (threads > 0)
+    {
+        return threads;
+    }
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void als::utilities::parallel_for(const size_t count, size_t threads,
+    const std::function<void(size_t, size_t)>& f)
+{
+    threads = std::max<size_t>(1, std::min(thread_count(threads), count));
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex mutex;
+
+    const auto work = [&](const size_t worker)
+    {
+        while (!failed)
+        {
+            const size_t task = next++;
+            if (task >= count)
+            {
+                return;
+            }
+            try
+            {
+                f(task, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    try
+    {
+        for (size_t worker = 1; worker < threads; worker++)
+        {
+            pool.emplace_back(work, worker);
+        }
+    }
+    catch (...)
+    {
+        // The threads already started must be joined before the pool is destroyed.
+        failed = true;
+        for (std::thread& thread : pool)
+        {
+            thread.join();
+        }
+        throw;
+    }
+    work(0);
+    for (std::thread& thread : pool)
+    {
+        thread.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+#endif // ALS_UTILITIES_SEGMENTED_CPP
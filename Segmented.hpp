@@ -0,0 +1,472 @@
+/** 
+ * @file Segmented.hpp
+ * @brief This file contains functions to write and read huge vectors in
+ * parallel, as independent segments.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * @a write_segmented_to_file splits a std::vector into segments of about
+ * SegmentOptions::segment_size bytes, encodes them on several threads and writes
+ * them with pwrite, so that every core contributes. @a read_segmented_from_file
+ * decodes the segments on several threads straight into the destination vector.
+ * 
+ * Each segment is an archive (see Archive.hpp) with some of the elements,
+ * optionally compressed (see Compression.hpp). The file layout is:
+ * - 4 bytes: SEGMENTED_FILE_MAGIC.
+ * - 4 bytes: flags (SEGMENTED_FILE_COMPRESSED, SEGMENTED_FILE_CHECKSUMS).
+ * - 8 bytes: number of elements.
+ * - 8 bytes: number of segments.
+ * - 8 bytes: offset of the index.
+ * - The segments, in any order.
+ * - The index: for each segment, its offset, its size in bytes and its number
+ * of elements (64 bits each), its CRC32C (see Checksum.hpp) and 4 reserved bytes.
+ * 
+ * Vectors of bitwise serializable types that are not compressed are written
+ * and read in place, without intermediate buffers.
+ */
+
+#ifndef ALS_UTILITIES_SEGMENTED_HPP
+#define ALS_UTILITIES_SEGMENTED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Archive.hpp"
+#include "Checksum.hpp"
+#include "Compression.hpp"
+#include "FileOperations.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Magic number at the beginning of segmented files.
+     */
+    inline constexpr unsigned char SEGMENTED_FILE_MAGIC[4] = {'A', 'L', 'S', 'S'};
+
+    /**
+     * @brief Flag of segmented files whose segments are compressed.
+     */
+    inline constexpr std::uint32_t SEGMENTED_FILE_COMPRESSED = 1;
+
+    /**
+     * @brief Flag of segmented files whose index has the checksums of the segments.
+     */
+    inline constexpr std::uint32_t SEGMENTED_FILE_CHECKSUMS = 2;
+
+    /**
+     * @brief Size in bytes of the header of a segmented file.
+     */
+    inline constexpr size_t SEGMENTED_FILE_HEADER_SIZE = 32;
+
+    /**
+     * @brief Size in bytes of an entry of the index of a segmented file.
+     */
+    inline constexpr size_t SEGMENTED_FILE_INDEX_ENTRY_SIZE = 32;
+
+    /**
+     * @brief Options of @a write_segmented_to_file and @a read_segmented_from_file .
+     * 
+     */
+    struct SegmentOptions
+    {
+        /**
+         * @brief Number of threads. Zero means one per core.
+         */
+        size_t threads = 0;
+
+        /**
+         * @brief Approximate size in bytes of the elements of each segment,
+         * measured with sizeof.
+         */
+        size_t segment_size = 64 << 20;
+
+        /**
+         * @brief Whether the segments are compressed. Only used for writing.
+         */
+        bool compress = false;
+
+        /**
+         * @brief Whether the checksums of the segments are stored and checked.
+         */
+        bool checksums = true;
+    };
+
+    /**
+     * @brief File descriptor that is closed when it goes out of scope.
+     * 
+     */
+    class FileDescriptor
+    {
+    public:
+        /**
+         * @brief Opens a file for reading or creates (or truncates) it for writing.
+         * Throws std::system_error on failure.
+         * 
+         * @param path
+         * @param write
+         */
+        FileDescriptor(const std::string& path, const bool write);
+
+        FileDescriptor(const FileDescriptor&) = delete;
+        FileDescriptor& operator=(const FileDescriptor&) = delete;
+        ~FileDescriptor();
+
+        int get() const { return fd_; }
+
+        /**
+         * @brief Returns the size of the file in bytes. Throws std::system_error
+         * on failure.
+         * 
+         * @return size_t
+         */
+        size_t size() const;
+
+    private:
+        int fd_;
+    };
+
+    /**
+     * @brief Writes a buffer at a given offset of a file with pwrite.
+     * Throws std::system_error on failure.
+     * 
+     * @param fd
+     * @param data
+     * @param bytes
+     * @param offset
+     */
+    void write_at(const int fd, const void* data, size_t bytes, size_t offset);
+
+    /**
+     * @brief Reads a buffer from a given offset of a file with pread.
+     * Throws std::system_error on failure and std::runtime_error if the
+     * file is too short.
+     * 
+     * @param fd
+     * @param data
+     * @param bytes
+     * @param offset
+     */
+    void read_at(const int fd, void* data, size_t bytes, size_t offset);
+
+    /**
+     * @brief Calls f(task, worker) for every task in [0, count) on a pool of
+     * threads, where worker in [0, threads) identifies the calling thread.
+     * The first exception thrown by f stops the remaining tasks and is rethrown.
+     * 
+     * @param count number of tasks.
+     * @param threads number of threads. Zero means one per core.
+     * @param f
+     */
+    void parallel_for(const size_t count, size_t threads, const std::function<void(size_t, size_t)>& f);
+
+    /**
+     * @brief Returns the number of threads to use, given the requested number.
+     * 
+     * @param threads zero means one per core.
+     * @return size_t
+     */
+    size_t thread_count(const size_t threads);
+
+    /**
+     * @brief Encodes a segment of elements as an archive, optionally compressed.
+     * 
+     * @tparam T
+     * @param data
+     * @param count
+     * @param compress
+     * @param buffer buffer whose contents are replaced by the segment.
+     */
+    template <class T>
+    void inline encode_segment(const T* data, const size_t count, const bool compress, std::vector<std::byte>& buffer)
+    {
+        const auto write_elements = [&](auto& archive)
+        {
+            if constexpr (is_bitwise_serializable_v<T>)
+            {
+                write_array_to_file(data, count, archive);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    write_to_file(data[i], archive);
+                }
+            }
+        };
+
+        buffer.clear();
+        MemorySink memory(buffer);
+        if (compress)
+        {
+            CompressedSink<MemorySink> compressed(memory);
+            {
+                ArchiveSink<CompressedSink<MemorySink>> archive(compressed);
+                write_elements(archive);
+            }
+            compressed.close();
+        }
+        else
+        {
+            ArchiveSink<MemorySink> archive(memory);
+            write_elements(archive);
+        }
+    }
+
+    /**
+     * @brief Decodes a segment written by @a encode_segment .
+     * 
+     * @tparam T
+     * @param segment
+     * @param compressed
+     * @param data
+     * @param count
+     */
+    template <class T>
+    void inline decode_segment(std::span<const std::byte> segment, const bool compressed, T* data, const size_t count)
+    {
+        const auto read_elements = [&](auto& archive)
+        {
+            if constexpr (is_bitwise_serializable_v<T>)
+            {
+                read_array_from_file(data, count, archive);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    read_from_file(data[i], archive);
+                }
+            }
+        };
+
+        SpanSource source(segment);
+        if (compressed)
+        {
+            CompressedSource<SpanSource> decompressed(source);
+            ArchiveSource<CompressedSource<SpanSource>> archive(decompressed);
+            read_elements(archive);
+        }
+        else
+        {
+            ArchiveSource<SpanSource> archive(source);
+            read_elements(archive);
+        }
+    }
+
+    /**
+     * @brief Writes a std::vector to a new file as independent segments, on
+     * several threads. Throws std::system_error if the file cannot be written.
+     * 
+     * @tparam T
+     * @param object
+     * @param path
+     * @param options
+     */
+    template <class T>
+    void write_segmented_to_file(const std::vector<T>& object, const std::string& path,
+        const SegmentOptions& options = SegmentOptions())
+    {
+        static_assert(!std::is_same_v<T, bool>, "std::vector<bool> cannot be segmented.");
+        const size_t N = object.size();
+        const size_t per_segment = std::max<size_t>(1, options.segment_size / sizeof(T));
+        const size_t segments = (N + per_segment - 1) / per_segment;
+        const size_t threads = std::min(thread_count(options.threads), std::max<size_t>(segments, 1));
+        std::vector<std::uint64_t> index(4 * segments, 0);
+
+        FileDescriptor file(path, true);
+        const int fd = file.get();
+        if constexpr (is_bitwise_serializable_v<T>)
+        {
+            if (!options.compress)
+            {
+                // The size of every segment is known, so each thread writes its
+                // segments in place at precomputed offsets.
+                std::byte header[FILE_HEADER_SIZE];
+                encode_file_header(FileFormat(), header);
+                const size_t segment_bytes = FILE_HEADER_SIZE + per_segment * sizeof(T);
+                parallel_for(segments, threads, [&](const size_t i, size_t)
+                {
+                    const size_t first = i * per_segment;
+                    const size_t count = std::min(per_segment, N - first);
+                    const size_t offset = SEGMENTED_FILE_HEADER_SIZE + i * segment_bytes;
+                    write_at(fd, header, FILE_HEADER_SIZE, offset);
+                    write_at(fd, object.data() + first, count * sizeof(T), offset + FILE_HEADER_SIZE);
+                    index[4 * i] = offset;
+                    index[4 * i + 1] = FILE_HEADER_SIZE + count * sizeof(T);
+                    index[4 * i + 2] = count;
+                    if (options.checksums)
+                    {
+                        index[4 * i + 3] = crc32c(object.data() + first, count * sizeof(T),
+                            crc32c(header, FILE_HEADER_SIZE));
+                    }
+                });
+            }
+        }
+        if (!is_bitwise_serializable_v<T> || options.compress)
+        {
+            // Each thread encodes a segment in its own buffer, reserves room for
+            // it at the end of the file and writes it there.
+            std::atomic<std::uint64_t> end(SEGMENTED_FILE_HEADER_SIZE);
+            std::vector<std::vector<std::byte>> buffers(threads);
+            parallel_for(segments, threads, [&](const size_t i, const size_t worker)
+            {
+                const size_t first = i * per_segment;
+                const size_t count = std::min(per_segment, N - first);
+                std::vector<std::byte>& buffer = buffers[worker];
+                encode_segment(object.data() + first, count, options.compress, buffer);
+                const std::uint64_t offset = end.fetch_add(buffer.size());
+                write_at(fd, buffer.data(), buffer.size(), offset);
+                index[4 * i] = offset;
+                index[4 * i + 1] = buffer.size();
+                index[4 * i + 2] = count;
+                if (options.checksums)
+                {
+                    index[4 * i + 3] = crc32c(buffer.data(), buffer.size());
+                }
+            });
+        }
+
+        // Finally, the index and the header.
+        std::uint64_t index_offset = SEGMENTED_FILE_HEADER_SIZE;
+        for (size_t i = 0; i < segments; i++)
+        {
+            index_offset = std::max(index_offset, index[4 * i] + index[4 * i + 1]);
+        }
+        write_at(fd, index.data(), index.size() * sizeof(std::uint64_t), index_offset);
+
+        const std::uint32_t flags = (options.compress ? SEGMENTED_FILE_COMPRESSED : 0)
+            | (options.checksums ? SEGMENTED_FILE_CHECKSUMS : 0);
+        const std::uint64_t header[3] = {N, segments, index_offset};
+        std::byte buffer[SEGMENTED_FILE_HEADER_SIZE];
+        std::memcpy(buffer, SEGMENTED_FILE_MAGIC, 4);
+        std::memcpy(buffer + 4, &flags, 4);
+        std::memcpy(buffer + 8, header, sizeof(header));
+        write_at(fd, buffer, SEGMENTED_FILE_HEADER_SIZE, 0);
+    }
+
+    /**
+     * @brief Reads a std::vector written by @a write_segmented_to_file , on several
+     * threads. The vector is resized and every segment is decoded straight into it.
+     * Throws std::runtime_error if the file is not valid or a checksum does not match.
+     * 
+     * @tparam T
+     * @param object
+     * @param path
+     * @param options only SegmentOptions::threads and SegmentOptions::checksums are used.
+     */
+    template <class T>
+    void read_segmented_from_file(std::vector<T>& object, const std::string& path,
+        const SegmentOptions& options = SegmentOptions())
+    {
+        static_assert(!std::is_same_v<T, bool>, "std::vector<bool> cannot be segmented.");
+        FileDescriptor file(path, false);
+        const int fd = file.get();
+
+        std::byte buffer[SEGMENTED_FILE_HEADER_SIZE];
+        std::uint32_t flags;
+        std::uint64_t header[3];
+        read_at(fd, buffer, SEGMENTED_FILE_HEADER_SIZE, 0);
+        std::memcpy(&flags, buffer + 4, 4);
+        std::memcpy(header, buffer + 8, sizeof(header));
+        if (std::memcmp(buffer, SEGMENTED_FILE_MAGIC, 4) != 0)
+        {
+            throw std::runtime_error("read_segmented_from_file: not a segmented file.");
+        }
+        const std::uint64_t N = header[0];
+        const std::uint64_t segments = header[1];
+        const std::uint64_t index_offset = header[2];
+        const size_t file_size = file.size();
+        if (segments > N || index_offset < SEGMENTED_FILE_HEADER_SIZE || index_offset > file_size
+            || segments > (file_size - index_offset) / SEGMENTED_FILE_INDEX_ENTRY_SIZE)
+        {
+            throw std::runtime_error("read_segmented_from_file: invalid index.");
+        }
+        std::vector<std::uint64_t> index(4 * segments);
+        read_at(fd, index.data(), index.size() * sizeof(std::uint64_t), index_offset);
+
+        // Every segment must lie inside the file and start where the previous ones end.
+        std::vector<size_t> first(segments + 1, 0);
+        for (size_t i = 0; i < segments; i++)
+        {
+            const std::uint64_t offset = index[4 * i];
+            const std::uint64_t size = index[4 * i + 1];
+            const std::uint64_t count = index[4 * i + 2];
+            if (offset > file_size || size > file_size - offset || count > N - first[i])
+            {
+                throw std::runtime_error("read_segmented_from_file: invalid index.");
+            }
+            first[i + 1] = first[i] + count;
+        }
+        if (first[segments] != N)
+        {
+            throw std::runtime_error("read_segmented_from_file: invalid index.");
+        }
+
+        const bool compressed = (flags & SEGMENTED_FILE_COMPRESSED) != 0;
+        const bool check = options.checksums && (flags & SEGMENTED_FILE_CHECKSUMS) != 0;
+        const auto verify = [&](const size_t i, const std::uint32_t crc)
+        {
+            if (check && crc != index[4 * i + 3])
+            {
+                throw std::runtime_error("read_segmented_from_file: checksum mismatch.");
+            }
+        };
+
+        object.resize(N);
+        const size_t threads = std::min(thread_count(options.threads), std::max<size_t>(segments, 1));
+        std::vector<std::vector<std::byte>> buffers(threads);
+        parallel_for(segments, threads, [&](const size_t i, const size_t worker)
+        {
+            const std::uint64_t offset = index[4 * i];
+            const std::uint64_t size = index[4 * i + 1];
+            const size_t count = index[4 * i + 2];
+            if constexpr (is_bitwise_serializable_v<T>)
+            {
+                if (!compressed && size >= FILE_HEADER_SIZE && (size - FILE_HEADER_SIZE) % sizeof(T) == 0
+                    && (size - FILE_HEADER_SIZE) / sizeof(T) == count)
+                {
+                    std::byte segment_header[FILE_HEADER_SIZE];
+                    read_at(fd, segment_header, FILE_HEADER_SIZE, offset);
+                    if (!has_file_header(segment_header, FILE_HEADER_SIZE))
+                    {
+                        throw std::runtime_error("read_segmented_from_file: invalid segment.");
+                    }
+                    // The elements are read in place, unless they were written in
+                    // a format that must be converted on this machine.
+                    if (!needs_conversion<T>(decode_file_header(segment_header)))
+                    {
+                        read_at(fd, object.data() + first[i], count * sizeof(T), offset + FILE_HEADER_SIZE);
+                        if (check)
+                        {
+                            verify(i, crc32c(object.data() + first[i], count * sizeof(T),
+                                crc32c(segment_header, FILE_HEADER_SIZE)));
+                        }
+                        return;
+                    }
+                }
+            }
+            std::vector<std::byte>& segment = buffers[worker];
+            segment.resize(size);
+            read_at(fd, segment.data(), size, offset);
+            if (check)
+            {
+                verify(i, crc32c(segment.data(), size));
+            }
+            decode_segment(std::span<const std::byte>(segment), compressed, object.data() + first[i], count);
+        });
+    }
+}
+
+#endif // ALS_UTILITIES_SEGMENTED_HPP
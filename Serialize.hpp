@@ -0,0 +1,111 @@
+/** 
+ * @file Serialize.hpp
+ * @brief This file contains functions to serialize objects to memory buffers.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * This file provides functions @a serialize , @a serialize_into and @a deserialize ,
+ * which use exactly the same encoding as @a write_to_file and @a read_from_file
+ * but work on memory buffers, without any system call. Thus, an object can be
+ * serialized with @a serialize and read back from a file with @a read_from_file ,
+ * or the other way round.
+ */
+
+#ifndef ALS_UTILITIES_SERIALIZE_HPP
+#define ALS_UTILITIES_SERIALIZE_HPP
+
+#include <cstddef>
+
+#include <span>
+#include <vector>
+
+#include "FileOperations.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief Serializes an object into a buffer, replacing its contents.
+     * The capacity of the buffer is reused, so calling this function repeatedly
+     * with the same buffer does not allocate memory once it is big enough.
+     * 
+     * @tparam T
+     * @param object
+     * @param buffer
+     */
+    template <class T>
+    void inline serialize(const T& object, std::vector<std::byte>& buffer)
+    {
+        buffer.clear();
+        MemorySink sink(buffer);
+        write_to_file(object, sink);
+    }
+
+    /**
+     * @brief Returns a buffer with the serialization of an object.
+     * 
+     * @tparam T
+     * @param object
+     * @return std::vector<std::byte>
+     */
+    template <class T>
+    std::vector<std::byte> inline serialize(const T& object)
+    {
+        std::vector<std::byte> buffer;
+        serialize(object, buffer);
+        return buffer;
+    }
+
+    /**
+     * @brief Serializes an object into a fixed buffer.
+     * Throws std::length_error if the buffer is too small.
+     * 
+     * @tparam T
+     * @param object
+     * @param buffer
+     * @return std::span<std::byte> the part of the buffer that has been written.
+     */
+    template <class T>
+    std::span<std::byte> inline serialize_into(const T& object, std::span<std::byte> buffer)
+    {
+        SpanSink sink(buffer);
+        write_to_file(object, sink);
+        return sink.written();
+    }
+
+    /**
+     * @brief Reads an object from a buffer. Throws std::runtime_error if the
+     * buffer is too short.
+     * 
+     * @tparam T
+     * @param object
+     * @param buffer
+     * @return size_t number of bytes read.
+     */
+    template <class T>
+    size_t inline deserialize(T& object, std::span<const std::byte> buffer)
+    {
+        SpanSource source(buffer);
+        read_from_file(object, source);
+        return source.tell();
+    }
+
+    /**
+     * @brief Returns an object read from a buffer. Throws std::runtime_error if the
+     * buffer is too short.
+     * 
+     * @tparam T
+     * @param buffer
+     * @return T
+     */
+    template <class T>
+    T inline deserialize(std::span<const std::byte> buffer)
+    {
+        T object;
+        deserialize(object, buffer);
+        return object;
+    }
+}
+
+#endif // ALS_UTILITIES_SERIALIZE_HPP
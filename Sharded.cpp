@@ -0,0 +1,280 @@
+#ifndef ALS_UTILITIES_SHARDED_CPP
+#define ALS_UTILITIES_SHARDED_CPP
+
+#include "Sharded.hpp"
+
+#include <cstdio>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "Checkpoint.hpp"
+#include "Segmented.hpp"
+
+using namespace als::utilities;
+
+namespace
+{
+    std::string shard_directory(const ShardOptions& options, const size_t i)
+    {
+        return options.directories.empty() ? std::string() : options.directories[i % options.directories.size()];
+    }
+
+    // The shards are written and read by one thread each, since the work is
+    // bound by the disks rather than by the processors.
+    size_t shard_threads(const ShardOptions& options, const size_t shards)
+    {
+        return (options.threads > 0) ? options.threads : std::max<size_t>(shards, 1);
+    }
+
+    struct Manifest
+    {
+        std::uint64_t identifier;
+        std::vector<std::string> paths;
+        std::vector<std::uint64_t> layout;
+    };
+
+    Manifest read_manifest(const std::string& path)
+    {
+        Manifest manifest;
+        FdSource file(path);
+        ArchiveSource archive(file);
+        read_from_file(manifest.identifier, archive);
+        read_from_file(manifest.paths, archive);
+        read_from_file(manifest.layout, archive);
+        return manifest;
+    }
+
+    std::string file_name(const std::string& path)
+    {
+        const size_t slash = path.find_last_of('/');
+        return (slash == std::string::npos) ? path : path.substr(slash + 1);
+    }
+
+    bool is_shard_of(const std::string& shard, const std::string& path)
+    {
+        const std::string name = file_name(shard);
+        const std::string prefix = file_name(path) + ".";
+        return name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0
+            && name.find(".shard", prefix.size()) != std::string::npos;
+    }
+
+    void remove_files(const std::vector<std::string>& paths)
+    {
+        for (const std::string& path : paths)
+        {
+            std::remove(path.c_str());
+        }
+    }
+}
+
+// ShardedArchiveWriter.
+ShardedArchiveWriter::ShardedArchiveWriter(std::string path, ShardOptions options)
+    : path_(std::move(path)), options_(std::move(options))
+{
+}
+
+size_t ShardedArchiveWriter::shards() const
+{
+    if (options_.shards > 0)
+    {
+        return options_.shards;
+    }
+    return std::max<size_t>(options_.directories.size(), 1);
+}
+
+void ShardedArchiveWriter::write()
+{
+    const size_t count = shards();
+    const FileFormat& format = options_.format;
+    const bool balanced = (options_.placement == ShardPlacement::SIZE_BALANCED);
+
+    // Sizes are only needed to balance the shards, and then they also reserve
+    // their space.
+    std::vector<size_t> sizes(entries_.size(), 0);
+    if (balanced)
+    {
+        for (size_t j = 0; j < entries_.size(); j++)
+        {
+            sizes[j] = entries_[j].size(format);
+        }
+    }
+    const std::vector<size_t> placement = place(sizes);
+    std::vector<std::vector<size_t>> members(count);
+    for (size_t j = 0; j < entries_.size(); j++)
+    {
+        members[placement[j]].push_back(j);
+    }
+
+    std::random_device random;
+    const std::uint64_t identifier = (static_cast<std::uint64_t>(random()) << 32) ^ random();
+    std::vector<std::string> paths(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        paths[i] = shard_path(path_, shard_directory(options_, i), identifier, i);
+    }
+
+    // The shards of the manifest being replaced are removed at the end. Only
+    // files named like shards of this archive are considered.
+    std::vector<std::string> previous;
+    try
+    {
+        for (const std::string& shard : read_manifest(path_).paths)
+        {
+            if (is_shard_of(shard, path_))
+            {
+                previous.push_back(shard);
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+    }
+
+    std::vector<std::uint64_t> layout(2 * entries_.size());
+    try
+    {
+        write_shards(identifier, paths, members, sizes, layout);
+
+        // The manifest is replaced once every shard is complete.
+        write_archive_atomically(path_, format, [&](ArchiveSink<FdSink>& archive)
+        {
+            write_to_file(identifier, archive);
+            write_to_file(paths, archive);
+            write_to_file(layout, archive);
+        });
+    }
+    catch (...)
+    {
+        // Unless the new manifest made it to its place, the previous manifest
+        // and its shards are left as they were.
+        bool replaced = false;
+        try
+        {
+            replaced = (read_manifest(path_).identifier == identifier);
+        }
+        catch (const std::exception&)
+        {
+        }
+        if (!replaced)
+        {
+            remove_files(paths);
+        }
+        throw;
+    }
+    remove_files(previous);
+}
+
+void ShardedArchiveWriter::write_shards(const std::uint64_t identifier, const std::vector<std::string>& paths,
+    const std::vector<std::vector<size_t>>& members, const std::vector<size_t>& sizes,
+    std::vector<std::uint64_t>& layout) const
+{
+    const FileFormat& format = options_.format;
+    const bool balanced = (options_.placement == ShardPlacement::SIZE_BALANCED);
+    parallel_for(paths.size(), shard_threads(options_, paths.size()), [&](const size_t i, size_t)
+    {
+        size_t bytes = 0;
+        if (balanced)
+        {
+            bytes = FILE_HEADER_SIZE + sizeof(identifier);
+            for (const size_t j : members[i])
+            {
+                bytes += sizes[j];
+            }
+        }
+        write_archive_atomically(paths[i], format, bytes, [&](ArchiveSink<FdSink>& archive)
+        {
+            write_to_file(identifier, archive);
+            for (const size_t j : members[i])
+            {
+                const size_t start = archive.tell();
+                entries_[j].write(archive);
+                layout[2 * j] = i;
+                layout[2 * j + 1] = archive.tell() - start;
+            }
+        });
+    });
+}
+
+std::vector<size_t> ShardedArchiveWriter::place(const std::vector<size_t>& sizes) const
+{
+    const size_t count = shards();
+    std::vector<size_t> placement(sizes.size());
+    if (options_.placement == ShardPlacement::ROUND_ROBIN)
+    {
+        for (size_t j = 0; j < sizes.size(); j++)
+        {
+            placement[j] = j % count;
+        }
+        return placement;
+    }
+
+    // Largest objects first, each one to the shard with the fewest bytes so far.
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
+    {
+        return sizes[a] > sizes[b];
+    });
+    std::vector<size_t> loads(count, 0);
+    for (const size_t j : order)
+    {
+        const size_t i = std::min_element(loads.begin(), loads.end()) - loads.begin();
+        placement[j] = i;
+        loads[i] += sizes[j];
+    }
+    return placement;
+}
+
+// ShardedArchiveReader.
+ShardedArchiveReader::ShardedArchiveReader(std::string path, ShardOptions options)
+    : path_(std::move(path)), options_(std::move(options))
+{
+}
+
+void ShardedArchiveReader::read()
+{
+    const Manifest manifest = read_manifest(path_);
+    const std::uint64_t identifier = manifest.identifier;
+    const std::vector<std::string>& paths = manifest.paths;
+    const std::vector<std::uint64_t>& layout = manifest.layout;
+    if (layout.size() != 2 * entries_.size())
+    {
+        throw std::runtime_error("ShardedArchiveReader: the number of objects does not match.");
+    }
+    std::vector<std::vector<size_t>> members(paths.size());
+    for (size_t j = 0; j < entries_.size(); j++)
+    {
+        if (layout[2 * j] >= paths.size())
+        {
+            throw std::runtime_error("ShardedArchiveReader: malformed manifest.");
+        }
+        members[layout[2 * j]].push_back(j);
+    }
+
+    parallel_for(paths.size(), shard_threads(options_, paths.size()), [&](const size_t i, size_t)
+    {
+        PrefetchSource file(paths[i]);
+        ArchiveSource archive(file);
+        std::uint64_t shard_identifier;
+        read_from_file(shard_identifier, archive);
+        if (shard_identifier != identifier)
+        {
+            throw std::runtime_error("ShardedArchiveReader: " + paths[i] + " belongs to another archive.");
+        }
+        for (const size_t j : members[i])
+        {
+            const size_t start = archive.tell();
+            entries_[j](archive);
+            if (archive.tell() - start != layout[2 * j + 1])
+            {
+                throw std::runtime_error("ShardedArchiveReader: malformed object.");
+            }
+        }
+    });
+}
+
+#endif // ALS_UTILITIES_SHARDED_CPP
@@ -0,0 +1,276 @@
+/** 
+ * @file Sharded.hpp
+ * @brief This file contains archives that are split into several files, which
+ * are written and read in parallel.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A single file is limited by the bandwidth of the device it lives on. A
+ * sharded archive spreads the objects written with @a write_to_file over
+ * several files (the shards), ideally in directories on different disks, and
+ * writes and reads all of them at the same time:
+ * 
+ * ShardOptions options;
+ * options.directories = {"/nvme0/ckpt", "/nvme1/ckpt", "/nvme2/ckpt", "/nvme3/ckpt"};
+ * ShardedArchiveWriter writer("/home/user/state.bin", options);
+ * for (const auto& column : columns)
+ * {
+ *     writer.add(column);
+ * }
+ * writer.write();
+ * 
+ * ShardedArchiveReader reader("/home/user/state.bin");
+ * for (auto& column : columns)
+ * {
+ *     reader.add(column);
+ * }
+ * reader.read();
+ * 
+ * @a write_sharded_to_file and @a read_sharded_from_file do the same with a
+ * fixed list of objects. Every object goes whole to one shard, either in turns
+ * (round robin) or to the shard with the fewest bytes so far, largest objects
+ * first (size balanced, see @a serialized_size ).
+ * 
+ * Each shard is an archive (see Archive.hpp) that contains a random identifier
+ * of the write (64 bits) followed by its objects, in the order in which they
+ * were added. The manifest, at the given path, is an archive with the
+ * identifier, a vector with the paths of the shards and a vector with, for each
+ * object, its shard and its size in bytes (64 bits each).
+ * 
+ * The names of the shards contain the identifier (see @a shard_path ), so a
+ * write never touches the shards of the previous one. The manifest is replaced
+ * atomically (see @a write_archive_atomically ) once every shard is complete,
+ * and only then are the shards of the previous manifest removed: if the
+ * process dies halfway, the previous archive is still whole. The reader
+ * checks that every shard belongs to the manifest.
+ */
+
+#ifndef ALS_UTILITIES_SHARDED_HPP
+#define ALS_UTILITIES_SHARDED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Archive.hpp"
+#include "FileOperations.hpp"
+#include "Prefetch.hpp"
+#include "Streams.hpp"
+
+namespace als::utilities
+{
+    /**
+     * @brief How the objects of a sharded archive are assigned to the shards.
+     */
+    enum class ShardPlacement
+    {
+        ROUND_ROBIN,
+        SIZE_BALANCED
+    };
+
+    /**
+     * @brief Options of sharded archives.
+     * 
+     */
+    struct ShardOptions
+    {
+        /**
+         * @brief Directories of the shards, which are assigned to them in turns.
+         * If empty, the shards are written next to the manifest.
+         */
+        std::vector<std::string> directories;
+
+        /**
+         * @brief Number of shards. Zero means one per directory, or one if there
+         * are no directories. Only used for writing.
+         */
+        size_t shards = 0;
+
+        /**
+         * @brief How the objects are assigned to the shards. Only used for writing.
+         */
+        ShardPlacement placement = ShardPlacement::SIZE_BALANCED;
+
+        /**
+         * @brief Format of the archives. Only used for writing.
+         */
+        FileFormat format;
+
+        /**
+         * @brief Number of threads. Zero means one per shard.
+         */
+        size_t threads = 0;
+    };
+
+    /**
+     * @brief Returns the path of the i-th shard of a write of a sharded archive:
+     * path.identifier.shardi , with the identifier in hexadecimal.
+     * 
+     * @param path path of the manifest.
+     * @param directory directory of the shard, or an empty string for the
+     * directory of the manifest.
+     * @param identifier identifier of the write.
+     * @param i
+     * @return std::string
+     */
+    std::string inline shard_path(const std::string& path, const std::string& directory,
+        const std::uint64_t identifier, const size_t i)
+    {
+        char hexadecimal[17];
+        std::snprintf(hexadecimal, sizeof(hexadecimal), "%016llx", static_cast<unsigned long long>(identifier));
+        const std::string suffix = std::string(".") + hexadecimal + ".shard" + std::to_string(i);
+        if (directory.empty())
+        {
+            return path + suffix;
+        }
+        const size_t slash = path.find_last_of('/');
+        const std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        return directory + "/" + name + suffix;
+    }
+
+    /**
+     * @brief Writes objects to a sharded archive. The objects are referenced,
+     * not copied, so they must not change until @a write returns.
+     * 
+     */
+    class ShardedArchiveWriter
+    {
+    public:
+        /**
+         * @brief Construct a new Sharded Archive Writer object. Nothing is written
+         * until @a write is called.
+         * 
+         * @param path path of the manifest.
+         * @param options
+         */
+        explicit ShardedArchiveWriter(std::string path, ShardOptions options = ShardOptions());
+
+        /**
+         * @brief Adds an object to the archive.
+         * 
+         * @tparam T
+         * @param object
+         */
+        template <class T>
+        void add(const T& object)
+        {
+            entries_.push_back({
+                [&object](const FileFormat& format) { return serialized_size(object, format); },
+                [&object](ArchiveSink<FdSink>& archive) { write_to_file(object, archive); }
+            });
+        }
+
+        /**
+         * @brief Writes the shards in parallel and then the manifest, and removes
+         * the shards of the manifest it replaces.
+         * Throws std::system_error if a file cannot be written.
+         * 
+         */
+        void write();
+
+        /**
+         * @brief Returns the number of shards.
+         * 
+         * @return size_t
+         */
+        size_t shards() const;
+
+    private:
+        struct Entry
+        {
+            std::function<size_t(const FileFormat&)> size;
+            std::function<void(ArchiveSink<FdSink>&)> write;
+        };
+
+        std::vector<size_t> place(const std::vector<size_t>& sizes) const;
+        void write_shards(const std::uint64_t identifier, const std::vector<std::string>& paths,
+            const std::vector<std::vector<size_t>>& members, const std::vector<size_t>& sizes,
+            std::vector<std::uint64_t>& layout) const;
+
+        std::string path_;
+        ShardOptions options_;
+        std::vector<Entry> entries_;
+    };
+
+    /**
+     * @brief Reads the objects of a sharded archive, in the order in which they
+     * were added to the @a ShardedArchiveWriter .
+     * 
+     */
+    class ShardedArchiveReader
+    {
+    public:
+        /**
+         * @brief Construct a new Sharded Archive Reader object. Nothing is read
+         * until @a read is called.
+         * 
+         * @param path path of the manifest.
+         * @param options only ShardOptions::threads is used.
+         */
+        explicit ShardedArchiveReader(std::string path, ShardOptions options = ShardOptions());
+
+        /**
+         * @brief Adds the next object to be read.
+         * 
+         * @tparam T
+         * @param object
+         */
+        template <class T>
+        void add(T& object)
+        {
+            entries_.push_back([&object](ArchiveSource<PrefetchSource>& archive) { read_from_file(object, archive); });
+        }
+
+        /**
+         * @brief Reads the shards in parallel, each one with a @a PrefetchSource .
+         * Throws std::runtime_error if the archive is malformed, the number of
+         * objects does not match or a shard belongs to another write.
+         * 
+         */
+        void read();
+
+    private:
+        std::string path_;
+        ShardOptions options_;
+        std::vector<std::function<void(ArchiveSource<PrefetchSource>&)>> entries_;
+    };
+
+    /**
+     * @brief Writes objects to a sharded archive (see @a ShardedArchiveWriter ).
+     * 
+     * @tparam Ts
+     * @param path path of the manifest.
+     * @param options
+     * @param objects
+     */
+    template <class... Ts>
+    void inline write_sharded_to_file(const std::string& path, const ShardOptions& options, const Ts&... objects)
+    {
+        ShardedArchiveWriter writer(path, options);
+        (writer.add(objects), ...);
+        writer.write();
+    }
+
+    /**
+     * @brief Reads objects written by @a write_sharded_to_file .
+     * 
+     * @tparam Ts
+     * @param path path of the manifest.
+     * @param options only ShardOptions::threads is used.
+     * @param objects
+     */
+    template <class... Ts>
+    void inline read_sharded_from_file(const std::string& path, const ShardOptions& options, Ts&... objects)
+    {
+        ShardedArchiveReader reader(path, options);
+        (reader.add(objects), ...);
+        reader.read();
+    }
+}
+
+#endif // ALS_UTILITIES_SHARDED_HPP
@@ -0,0 +1,354 @@
+#ifndef ALS_UTILITIES_STREAMS_CPP
+#define ALS_UTILITIES_STREAMS_CPP
+
+#include "Streams.hpp"
+
+#include <cerrno>
+#include <algorithm>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace als::utilities;
+
+namespace
+{
+    // Unlocked stdio calls are a GNU extension; elsewhere we fall back to the locked ones.
+#ifdef __GLIBC__
+    size_t fwrite_without_lock(const void* data, size_t bytes, FILE* file)
+    {
+        return fwrite_unlocked(data, 1, bytes, file);
+    }
+
+    size_t fread_without_lock(void* data, size_t bytes, FILE* file)
+    {
+        return fread_unlocked(data, 1, bytes, file);
+    }
+#else
+    size_t fwrite_without_lock(const void* data, size_t bytes, FILE* file)
+    {
+        return fwrite(data, 1, bytes, file);
+    }
+
+    size_t fread_without_lock(void* data, size_t bytes, FILE* file)
+    {
+        return fread(data, 1, bytes, file);
+    }
+#endif
+
+    int open_or_throw(const std::string& path, const int flags)
+    {
+        const int fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+        return fd;
+    }
+
+    size_t current_offset(const int fd)
+    {
+        const off_t offset = lseek(fd, 0, SEEK_CUR);
+        return (offset < 0) ? 0 : offset;
+    }
+}
+
+// FileSink.
+FileSink::FileSink(FILE* file) : file_(file)
+{
+    flockfile(file_);
+}
+
+FileSink::~FileSink()
+{
+    funlockfile(file_);
+}
+
+void FileSink::write(const void* data, const size_t bytes)
+{
+    if (fwrite_without_lock(data, bytes, file_) != bytes)
+    {
+        throw std::system_error(errno, std::generic_category(), "FileSink: write failed");
+    }
+}
+
+void FileSink::flush()
+{
+    fflush(file_);
+}
+
+size_t FileSink::tell() const
+{
+    return ftell(file_);
+}
+
+void FileSink::patch(const size_t offset, const void* data, const size_t bytes)
+{
+    const long end = ftell(file_);
+    if (end < 0 || fseek(file_, offset, SEEK_SET) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "FileSink: seek failed");
+    }
+    write(data, bytes);
+    if (fseek(file_, end, SEEK_SET) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "FileSink: seek failed");
+    }
+}
+
+// FileSource.
+FileSource::FileSource(FILE* file) : file_(file)
+{
+    flockfile(file_);
+}
+
+FileSource::~FileSource()
+{
+    funlockfile(file_);
+}
+
+void FileSource::read(void* data, const size_t bytes)
+{
+    if (fread_without_lock(data, bytes, file_) != bytes)
+    {
+        if (ferror(file_))
+        {
+            throw std::system_error(errno, std::generic_category(), "FileSource: read failed");
+        }
+        throw EndOfData("FileSource: unexpected end of data.");
+    }
+}
+
+void FileSource::skip(const size_t bytes)
+{
+    if (fseek(file_, bytes, SEEK_CUR) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "FileSource: seek failed");
+    }
+}
+
+size_t FileSource::tell() const
+{
+    return ftell(file_);
+}
+
+// FdSink.
+FdSink::FdSink(const int fd, const size_t buffer_size, const long long offset)
+    : fd_(fd), owns_fd_(false), positional_(offset >= 0),
+    position_(positional_ ? offset : current_offset(fd)),
+    buffer_(new std::byte[std::max<size_t>(buffer_size, 1)]),
+    capacity_(std::max<size_t>(buffer_size, 1)), used_(0)
+{
+}
+
+FdSink::FdSink(const std::string& path, const size_t buffer_size)
+    : FdSink(open_or_throw(path, O_WRONLY | O_CREAT | O_TRUNC), buffer_size)
+{
+    owns_fd_ = true;
+}
+
+FdSink::~FdSink()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+    }
+    if (owns_fd_)
+    {
+        close(fd_);
+    }
+}
+
+void FdSink::write(const void* data, const size_t bytes)
+{
+    if (bytes <= capacity_ - used_)
+    {
+        std::memcpy(buffer_.get() + used_, data, bytes);
+        used_ += bytes;
+    }
+    else if (bytes >= capacity_)
+    {
+        // The data would not fit even in an empty buffer: write it together with
+        // whatever is buffered in a single system call.
+        write_all(buffer_.get(), used_, data, bytes);
+        used_ = 0;
+    }
+    else
+    {
+        flush();
+        std::memcpy(buffer_.get(), data, bytes);
+        used_ = bytes;
+    }
+}
+
+void FdSink::flush()
+{
+    write_all(buffer_.get(), used_, nullptr, 0);
+    used_ = 0;
+}
+
+void FdSink::patch(const size_t offset, const void* data, size_t bytes)
+{
+    const std::byte* source = static_cast<const std::byte*>(data);
+
+    // The part that has already been flushed is overwritten in the file...
+    size_t position = offset;
+    while (bytes > 0 && position < position_)
+    {
+        const ssize_t written = pwrite(fd_, source, std::min(bytes, position_ - position), position);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "FdSink: write failed");
+        }
+        source += written;
+        position += written;
+        bytes -= written;
+    }
+
+    // ... and the rest, in the buffer.
+    std::memcpy(buffer_.get() + (position - position_), source, bytes);
+}
+
+void FdSink::write_all(const void* first, size_t first_bytes, const void* second, size_t second_bytes)
+{
+    iovec parts[2] = {{const_cast<void*>(first), first_bytes}, {const_cast<void*>(second), second_bytes}};
+    iovec* part = parts;
+    int count = (second_bytes > 0) ? 2 : 1;
+    while (count > 0 && (part[0].iov_len > 0 || count > 1))
+    {
+        const ssize_t written = positional_ ? pwritev(fd_, part, count, position_)
+            : writev(fd_, part, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "FdSink: write failed");
+        }
+
+        // Partial writes are possible, so we advance through the parts.
+        position_ += written;
+        size_t remaining = written;
+        while (count > 0 && remaining >= part[0].iov_len)
+        {
+            remaining -= part[0].iov_len;
+            ++part;
+            --count;
+        }
+        if (count > 0)
+        {
+            part[0].iov_base = static_cast<std::byte*>(part[0].iov_base) + remaining;
+            part[0].iov_len -= remaining;
+        }
+    }
+}
+
+// FdSource.
+FdSource::FdSource(const int fd, const size_t buffer_size, const long long offset)
+    : fd_(fd), owns_fd_(false), positional_(offset >= 0),
+    position_(positional_ ? offset : current_offset(fd)),
+    buffer_(new std::byte[std::max<size_t>(buffer_size, 1)]),
+    capacity_(std::max<size_t>(buffer_size, 1)), begin_(0), end_(0)
+{
+}
+
+FdSource::FdSource(const std::string& path, const size_t buffer_size)
+    : FdSource(open_or_throw(path, O_RDONLY), buffer_size)
+{
+    owns_fd_ = true;
+}
+
+FdSource::~FdSource()
+{
+    if (owns_fd_)
+    {
+        close(fd_);
+    }
+}
+
+void FdSource::read(void* data, size_t bytes)
+{
+    std::byte* destination = static_cast<std::byte*>(data);
+
+    // First, we use whatever is left in the buffer.
+    const size_t buffered = std::min(bytes, end_ - begin_);
+    std::memcpy(destination, buffer_.get() + begin_, buffered);
+    begin_ += buffered;
+    destination += buffered;
+    bytes -= buffered;
+
+    // Large reads go straight to their destination; small ones refill the buffer.
+    while (bytes >= capacity_)
+    {
+        const size_t n = fill(destination, bytes);
+        destination += n;
+        bytes -= n;
+    }
+    while (bytes > 0)
+    {
+        end_ = fill(buffer_.get(), capacity_);
+        begin_ = 0;
+        const size_t n = std::min(bytes, end_);
+        std::memcpy(destination, buffer_.get(), n);
+        begin_ = n;
+        destination += n;
+        bytes -= n;
+    }
+}
+
+void FdSource::skip(size_t bytes)
+{
+    const size_t buffered = std::min(bytes, end_ - begin_);
+    begin_ += buffered;
+    bytes -= buffered;
+    if (bytes == 0)
+    {
+        return;
+    }
+    if (positional_ || lseek(fd_, bytes, SEEK_CUR) >= 0)
+    {
+        position_ += bytes;
+        return;
+    }
+
+    // The file descriptor is not seekable (e.g. a pipe), so we read and discard.
+    while (bytes > 0)
+    {
+        end_ = fill(buffer_.get(), capacity_);
+        begin_ = std::min(bytes, end_);
+        bytes -= begin_;
+    }
+}
+
+size_t FdSource::fill(void* data, const size_t bytes)
+{
+    while (true)
+    {
+        const ssize_t n = positional_ ? pread(fd_, data, bytes, position_) : ::read(fd_, data, bytes);
+        if (n > 0)
+        {
+            position_ += n;
+            return n;
+        }
+        if (n == 0)
+        {
+            throw EndOfData("FdSource: unexpected end of data.");
+        }
+        if (errno != EINTR)
+        {
+            throw std::system_error(errno, std::generic_category(), "FdSource: read failed");
+        }
+    }
+}
+
+#endif // ALS_UTILITIES_STREAMS_CPP
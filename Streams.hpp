@@ -0,0 +1,563 @@
+/** 
+ * @file Streams.hpp
+ * @brief This file contains the sinks and sources that @a write_to_file
+ * and @a read_from_file can write to and read from.
+ * @author Andrés Laín Sanclemente
+ * @version 0.8.0
+ * @date 16th October 2026
+ * 
+ * A sink is any object with the public methods
+ * write(const void* data, size_t bytes), flush() and tell().
+ * A source is any object with the public methods
+ * read(void* data, size_t bytes), skip(size_t bytes) and tell().
+ * Sources throw @a EndOfData , a std::runtime_error, when they run out of
+ * data, and so do FILE pointers.
+ * Sinks that can overwrite data they have already written also have the public
+ * method patch(size_t offset, const void* data, size_t bytes), where offset is a
+ * position previously returned by tell().
+ * 
+ * FILE pointers can be used directly as sinks and sources. Besides, we offer:
+ * - @a FileSink and @a FileSource : FILE pointer adapters that lock the file
+ * once instead of on every call.
+ * - @a FdSink and @a FdSource : POSIX file descriptors with a large user-space
+ * buffer. Big writes and reads bypass the buffer.
+ * - @a MemorySink : appends to a std::vector<std::byte>.
+ * - @a SpanSink and @a SpanSource : fixed memory buffers.
+ * 
+ * Streams may also describe the layout of the data they carry through a public
+ * method format() returning a @a FileFormat (see Archive.hpp). Streams without
+ * it use @a LEGACY_FILE_FORMAT .
+ */
+
+#ifndef ALS_UTILITIES_STREAMS_HPP
+#define ALS_UTILITIES_STREAMS_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+#include <bit>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace als::utilities
+{
+    /**
+     * @brief Default size in bytes of the buffer of @a FdSink and @a FdSource .
+     */
+    inline constexpr size_t DEFAULT_STREAM_BUFFER_SIZE = 4 << 20;
+
+    /**
+     * @brief Latest version of the format of archives (see Archive.hpp).
+     * 
+     * Version 1 introduced the header and 64-bit sizes. Version 2 added an encoding
+     * tag to vectors and deques of numbers (see Encodings.hpp). Version 3 stores the
+     * sizes of the strings of a vector of strings before all their characters.
+     * Version 4 added portable archives, whose numbers have fixed widths.
+     */
+    inline constexpr unsigned short FILE_FORMAT_VERSION = 4;
+
+    /**
+     * @brief Layout of the data written by @a write_to_file .
+     * 
+     */
+    struct FileFormat
+    {
+        /**
+         * @brief Version of the format. Version 0 is the original layout,
+         * which has no header.
+         */
+        unsigned short version = FILE_FORMAT_VERSION;
+
+        /**
+         * @brief Whether multi-byte values are stored in little-endian order.
+         */
+        bool little_endian = (std::endian::native == std::endian::little);
+
+        /**
+         * @brief Width in bytes (4 or 8) of the sizes of containers and strings.
+         */
+        unsigned char size_width = 8;
+
+        /**
+         * @brief Whether numbers are stored with fixed widths, regardless of the
+         * machine: long and unsigned long take 64 bits, wchar_t takes 32 bits and
+         * long double is stored as the sum of two doubles. Other numbers are
+         * stored with their usual width. Requires version 4 or later.
+         */
+        bool portable = false;
+    };
+
+    /**
+     * @brief Format of the files written before headers were introduced:
+     * native byte order and 32-bit sizes.
+     */
+    inline constexpr FileFormat LEGACY_FILE_FORMAT = {0, std::endian::native == std::endian::little, 4};
+
+    /**
+     * @brief Format of archives that can be read on any machine: little-endian,
+     * with fixed-width numbers and 64-bit sizes.
+     */
+    inline constexpr FileFormat PORTABLE_FILE_FORMAT = {FILE_FORMAT_VERSION, true, 8, true};
+
+    /**
+     * @brief Type used to store a stream inside another object: FILE pointers
+     * are stored by value and the rest of streams by reference.
+     * 
+     * @tparam Stream 
+     */
+    template <class Stream>
+    using stream_reference_t = std::conditional_t<std::is_pointer_v<Stream>, Stream, Stream&>;
+
+    /**
+     * @brief Exception thrown by sources that run out of data. Other failures
+     * throw other exceptions (e.g. std::system_error).
+     * 
+     */
+    class EndOfData : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Primitive operations.
+    void inline write_bytes(FILE* file, const void* data, const size_t bytes)
+    {
+        if (fwrite(data, 1, bytes, file) != bytes)
+        {
+            throw std::system_error(errno, std::generic_category(), "write_bytes: write failed");
+        }
+    }
+
+    template <class Sink>
+    void inline write_bytes(Sink& sink, const void* data, const size_t bytes)
+    {
+        sink.write(data, bytes);
+    }
+
+    void inline read_bytes(FILE* file, void* data, const size_t bytes)
+    {
+        if (fread(data, 1, bytes, file) != bytes)
+        {
+            if (ferror(file))
+            {
+                throw std::system_error(errno, std::generic_category(), "read_bytes: read failed");
+            }
+            throw EndOfData("read_bytes: unexpected end of data.");
+        }
+    }
+
+    template <class Source>
+    void inline read_bytes(Source& source, void* data, const size_t bytes)
+    {
+        source.read(data, bytes);
+    }
+
+    void inline skip_bytes(FILE* file, const size_t bytes)
+    {
+        if (fseek(file, bytes, SEEK_CUR) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "skip_bytes: seek failed");
+        }
+    }
+
+    template <class Source>
+    void inline skip_bytes(Source& source, const size_t bytes)
+    {
+        source.skip(bytes);
+    }
+
+    void inline flush_stream(FILE* file)
+    {
+        fflush(file);
+    }
+
+    template <class Sink>
+    void inline flush_stream(Sink& sink)
+    {
+        sink.flush();
+    }
+
+    /**
+     * @brief Overwrites bytes that have already been written at the given position.
+     * Throws std::system_error on failure.
+     * 
+     * @param file a seekable file.
+     * @param offset 
+     * @param data 
+     * @param bytes 
+     */
+    void inline patch_bytes(FILE* file, const size_t offset, const void* data, const size_t bytes)
+    {
+        const long end = ftell(file);
+        if (end < 0 || fseek(file, offset, SEEK_SET) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "patch_bytes: seek failed");
+        }
+        if (fwrite(data, 1, bytes, file) != bytes)
+        {
+            throw std::system_error(errno, std::generic_category(), "patch_bytes: write failed");
+        }
+        if (fseek(file, end, SEEK_SET) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "patch_bytes: seek failed");
+        }
+    }
+
+    template <class Sink>
+    void inline patch_bytes(Sink& sink, const size_t offset, const void* data, const size_t bytes)
+    {
+        sink.patch(offset, data, bytes);
+    }
+
+    /**
+     * @brief Returns the position of a stream in bytes, or -1 if it is unknown.
+     * 
+     * @param file
+     * @return long
+     */
+    long inline stream_position(FILE* file)
+    {
+        return ftell(file);
+    }
+
+    template <class Stream>
+    long inline stream_position(Stream& stream)
+    {
+        return stream.tell();
+    }
+
+    /**
+     * @brief Moves a stream to the given position in bytes, as returned by
+     * @a stream_position . Only FILE pointers and streams with the public method
+     * seek(size_t offset) (e.g. MappedFileReader) can be moved.
+     * 
+     * @param file a seekable file.
+     * @param offset 
+     */
+    void inline seek_stream(FILE* file, const size_t offset)
+    {
+        if (fseek(file, offset, SEEK_SET) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "seek_stream: seek failed");
+        }
+    }
+
+    template <class Stream>
+    void inline seek_stream(Stream& stream, const size_t offset)
+    {
+        stream.seek(offset);
+    }
+
+    /**
+     * @brief Returns the format of the data carried by a stream. A FileFormat
+     * stands for a stream with that format, for functions that only look at
+     * the format (such as serialized_size).
+     * 
+     * @tparam Stream 
+     * @param stream 
+     * @return FileFormat 
+     */
+    template <class Stream>
+    FileFormat inline stream_format(const Stream& stream)
+    {
+        if constexpr (std::is_same_v<Stream, FileFormat>)
+        {
+            return stream;
+        }
+        else if constexpr (requires { stream.format(); })
+        {
+            return stream.format();
+        }
+        else
+        {
+            return LEGACY_FILE_FORMAT;
+        }
+    }
+
+    /**
+     * @brief Sink that writes to a FILE pointer.
+     * 
+     * The file is locked while the sink is alive, so that each write does not
+     * have to acquire the lock again. It converts implicitly to FILE*, so objects
+     * that only implement write_to_file(FILE* file) can also be written to it.
+     */
+    class FileSink
+    {
+    public:
+        explicit FileSink(FILE* file);
+        FileSink(const FileSink&) = delete;
+        FileSink& operator=(const FileSink&) = delete;
+        ~FileSink();
+
+        void write(const void* data, const size_t bytes);
+        void flush();
+        size_t tell() const;
+        void patch(const size_t offset, const void* data, const size_t bytes);
+
+        operator FILE*() const { return file_; }
+
+    private:
+        FILE* file_;
+    };
+
+    /**
+     * @brief Source that reads from a FILE pointer.
+     * 
+     * The file is locked while the source is alive. It converts implicitly to FILE*,
+     * so objects that only implement read_from_file(FILE* file) can also be read from it.
+     */
+    class FileSource
+    {
+    public:
+        explicit FileSource(FILE* file);
+        FileSource(const FileSource&) = delete;
+        FileSource& operator=(const FileSource&) = delete;
+        ~FileSource();
+
+        void read(void* data, const size_t bytes);
+        void skip(const size_t bytes);
+        size_t tell() const;
+
+        operator FILE*() const { return file_; }
+
+    private:
+        FILE* file_;
+    };
+
+    /**
+     * @brief Buffered sink that writes to a POSIX file descriptor.
+     * 
+     * Small writes are gathered in the buffer. When it fills up, the buffer and the
+     * data that did not fit are written together with a single call to writev, or to
+     * pwritev when the sink writes at an explicit offset. The buffer is flushed on
+     * destruction, but errors can only be detected by calling @a flush beforehand.
+     */
+    class FdSink
+    {
+    public:
+        /**
+         * @brief Construct a new Fd Sink object that writes to an open file descriptor,
+         * which is not closed by the sink.
+         * 
+         * @param fd
+         * @param buffer_size size of the buffer in bytes.
+         * @param offset if non-negative, the sink writes with pwritev starting at
+         * this offset and leaves the position of the file descriptor untouched.
+         */
+        explicit FdSink(const int fd, const size_t buffer_size = DEFAULT_STREAM_BUFFER_SIZE,
+            const long long offset = -1);
+
+        /**
+         * @brief Construct a new Fd Sink object that creates (or truncates) a file.
+         * Throws std::system_error on failure.
+         * 
+         * @param path
+         * @param buffer_size size of the buffer in bytes.
+         */
+        explicit FdSink(const std::string& path, const size_t buffer_size = DEFAULT_STREAM_BUFFER_SIZE);
+
+        FdSink(const FdSink&) = delete;
+        FdSink& operator=(const FdSink&) = delete;
+        ~FdSink();
+
+        void write(const void* data, const size_t bytes);
+        void flush();
+        size_t tell() const { return position_ + used_; }
+        void patch(const size_t offset, const void* data, const size_t bytes);
+
+        /**
+         * @brief Returns the underlying file descriptor.
+         * 
+         * @return int
+         */
+        int fd() const { return fd_; }
+
+    private:
+        void write_all(const void* first, size_t first_bytes, const void* second, size_t second_bytes);
+
+        int fd_;
+        bool owns_fd_;
+        bool positional_;
+        size_t position_;
+        std::unique_ptr<std::byte[]> buffer_;
+        size_t capacity_;
+        size_t used_;
+    };
+
+    /**
+     * @brief Buffered source that reads from a POSIX file descriptor.
+     * 
+     * Reads that are larger than the buffer go straight to their destination.
+     */
+    class FdSource
+    {
+    public:
+        /**
+         * @brief Construct a new Fd Source object that reads from an open file descriptor,
+         * which is not closed by the source.
+         * 
+         * @param fd
+         * @param buffer_size size of the buffer in bytes.
+         * @param offset if non-negative, the source reads with pread starting at
+         * this offset and leaves the position of the file descriptor untouched.
+         */
+        explicit FdSource(const int fd, const size_t buffer_size = DEFAULT_STREAM_BUFFER_SIZE,
+            const long long offset = -1);
+
+        /**
+         * @brief Construct a new Fd Source object that opens a file.
+         * Throws std::system_error on failure.
+         * 
+         * @param path
+         * @param buffer_size size of the buffer in bytes.
+         */
+        explicit FdSource(const std::string& path, const size_t buffer_size = DEFAULT_STREAM_BUFFER_SIZE);
+
+        FdSource(const FdSource&) = delete;
+        FdSource& operator=(const FdSource&) = delete;
+        ~FdSource();
+
+        void read(void* data, size_t bytes);
+        void skip(size_t bytes);
+        size_t tell() const { return position_ - (end_ - begin_); }
+
+        /**
+         * @brief Returns the underlying file descriptor.
+         * 
+         * @return int
+         */
+        int fd() const { return fd_; }
+
+    private:
+        size_t fill(void* data, const size_t bytes);
+
+        int fd_;
+        bool owns_fd_;
+        bool positional_;
+        size_t position_;
+        std::unique_ptr<std::byte[]> buffer_;
+        size_t capacity_;
+        size_t begin_;
+        size_t end_;
+    };
+
+    /**
+     * @brief Sink that appends to a std::vector<std::byte>.
+     * 
+     */
+    class MemorySink
+    {
+    public:
+        explicit MemorySink(std::vector<std::byte>& buffer) : buffer_(buffer) {}
+
+        void write(const void* data, const size_t bytes)
+        {
+            const std::byte* first = static_cast<const std::byte*>(data);
+            buffer_.insert(buffer_.end(), first, first + bytes);
+        }
+
+        void flush() {}
+        size_t tell() const { return buffer_.size(); }
+
+        void patch(const size_t offset, const void* data, const size_t bytes)
+        {
+            std::memcpy(buffer_.data() + offset, data, bytes);
+        }
+
+    private:
+        std::vector<std::byte>& buffer_;
+    };
+
+    /**
+     * @brief Sink that writes to a fixed memory buffer.
+     * Throws std::length_error if the buffer is too small.
+     * 
+     */
+    class SpanSink
+    {
+    public:
+        explicit SpanSink(std::span<std::byte> buffer) : buffer_(buffer), used_(0) {}
+
+        void write(const void* data, const size_t bytes)
+        {
+            if (bytes > buffer_.size() - used_)
+            {
+                throw std::length_error("SpanSink: the buffer is full.");
+            }
+            std::memcpy(buffer_.data() + used_, data, bytes);
+            used_ += bytes;
+        }
+
+        void flush() {}
+        size_t tell() const { return used_; }
+
+        void patch(const size_t offset, const void* data, const size_t bytes)
+        {
+            std::memcpy(buffer_.data() + offset, data, bytes);
+        }
+
+        /**
+         * @brief Returns the part of the buffer that has been written.
+         * 
+         * @return std::span<std::byte>
+         */
+        std::span<std::byte> written() const { return buffer_.first(used_); }
+
+    private:
+        std::span<std::byte> buffer_;
+        size_t used_;
+    };
+
+    /**
+     * @brief Source that reads from a memory buffer.
+     * 
+     */
+    class SpanSource
+    {
+    public:
+        explicit SpanSource(std::span<const std::byte> buffer) : buffer_(buffer), position_(0) {}
+
+        void read(void* data, const size_t bytes)
+        {
+            check(bytes);
+            std::memcpy(data, buffer_.data() + position_, bytes);
+            position_ += bytes;
+        }
+
+        void skip(const size_t bytes)
+        {
+            check(bytes);
+            position_ += bytes;
+        }
+
+        size_t tell() const { return position_; }
+
+        /**
+         * @brief Returns the part of the buffer that has not been read yet.
+         * 
+         * @return std::span<const std::byte>
+         */
+        std::span<const std::byte> remaining() const { return buffer_.subspan(position_); }
+
+    private:
+        void check(const size_t bytes) const
+        {
+            if (bytes > buffer_.size() - position_)
+            {
+                throw EndOfData("SpanSource: unexpected end of data.");
+            }
+        }
+
+        std::span<const std::byte> buffer_;
+        size_t position_;
+    };
+}
+
+#endif // ALS_UTILITIES_STREAMS_HPP